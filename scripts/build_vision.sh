@@ -12,3 +12,4 @@ cmake ..
 cmake --build . -j
 
 echo "[OK] built: $ROOT/vision/bin/ght_face_eyes"
+echo "[OK] built: $ROOT/vision/lib/libght.{a,so} (C API: vision/include/ght.h)"
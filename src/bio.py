@@ -3,14 +3,13 @@ from __future__ import annotations
 
 import hashlib
 import os
-import tempfile
 from dataclasses import dataclass
 from typing import Optional, Tuple, Dict, Any
 
 import cv2
 import numpy as np
 
-from .vision_backend import detect_face_eyes_by_ght
+from .vision_backend import detect_face_eyes_from_array
 
 
 def sha256_file(path: str) -> str:
@@ -201,16 +200,8 @@ def _detect_eyes_fallback_haar(image_bgr: np.ndarray) -> Optional[EyeGeom]:
 
 
 def _detect_eyes_primary_ght(image_bgr: np.ndarray) -> Tuple[Optional[EyeGeom], str]:
-    with tempfile.NamedTemporaryFile(suffix=".png", delete=False) as tf:
-        tmp_path = tf.name
-    try:
-        cv2.imwrite(tmp_path, image_bgr)
-        det = detect_face_eyes_by_ght(tmp_path, headless=True)
-    finally:
-        try:
-            os.remove(tmp_path)
-        except Exception:
-            pass
+    # raw pixels straight to the detector: no PNG round trip, no temp file
+    det = detect_face_eyes_from_array(image_bgr)
 
     if not det.eyes_ok or det.eye1 is None or det.eye2 is None or det.eye_r is None:
         return None, f"ght_eyes_not_found:{det.raw}"
@@ -3,9 +3,12 @@ from __future__ import annotations
 
 import os
 import re
+import socket
+import struct
 import subprocess
+import threading
 from dataclasses import dataclass
-from typing import Optional, Tuple, List
+from typing import Dict, Optional, Tuple, List
 
 
 @dataclass
@@ -26,6 +29,24 @@ _EYES_RE = re.compile(
 )
 
 
+# Binary protocol of `ght_face_eyes --serve <socket>` (see EnteteRequete / ResultatFil in ght_face_eyes.cpp)
+_REQ_MAGIC = 0x31544847  # "GHT1"
+_RESP_MAGIC = 0x52544847  # "GHTR"
+_REQ_HDR = struct.Struct("<IIIiiiiiI")
+_RESP_HDR = struct.Struct("<III")
+_RESULT = struct.Struct("<15i")
+
+REQ_PATH = 1
+REQ_ENCODED = 2
+REQ_FRAME = 3
+
+_FLAG_EQ_HIST = 1 << 0
+_FLAG_CLAHE = 1 << 1
+_FLAG_AUTO_THR = 1 << 2
+
+_SOCKET_ENV = "GHT_FACE_EYES_SOCKET"
+
+
 def _default_bin_path() -> str:
     # CartePuce/vision/bin/ght_face_eyes
     here = os.path.dirname(os.path.abspath(__file__))
@@ -33,50 +54,351 @@ def _default_bin_path() -> str:
     return os.path.join(root, "vision", "bin", "ght_face_eyes")
 
 
-def detect_face_eyes_by_ght(
-    image_path: str,
-    bin_path: Optional[str] = None,
-    timeout_sec: int = 5,
-    headless: bool = True,
-    gui: bool = False,
-    gui_steps: bool = False,
-    gui_delay_ms: int = 0,
-    # New knobs (optional)
-    auto_threshold: bool = True,
-    face_edge: Optional[int] = None,
-    eye_edge: Optional[int] = None,
-    face_min_score: Optional[int] = None,
-    eye_min_peak: Optional[int] = None,
-    eq_hist: bool = True,
-    clahe: bool = False,
-    blur_k: int = 5,
-) -> FaceEyesDet:
+# In-process detector: _ght extension built next to the binary (vision/bin/_ght*.so)
+_native_detector = None
+_native_tried = False
+
+
+def _load_native_detector():
+    global _native_detector, _native_tried
+    if _native_tried:
+        return _native_detector
+    _native_tried = True
+    try:
+        import importlib.machinery
+        import importlib.util
+
+        bin_dir = os.path.dirname(_default_bin_path())
+        for suffix in importlib.machinery.EXTENSION_SUFFIXES:
+            path = os.path.join(bin_dir, "_ght" + suffix)
+            if os.path.exists(path):
+                spec = importlib.util.spec_from_file_location("_ght", path)
+                mod = importlib.util.module_from_spec(spec)
+                spec.loader.exec_module(mod)
+                _native_detector = mod.Detector()  # model bank built once, shared by threads
+                break
+    except Exception:
+        _native_detector = None
+    return _native_detector
+
+
+def _recv_exact(sock: socket.socket, n: int) -> bytes:
+    buf = bytearray()
+    while len(buf) < n:
+        chunk = sock.recv(n - len(buf))
+        if not chunk:
+            raise ConnectionError("vision daemon closed the connection")
+        buf.extend(chunk)
+    return bytes(buf)
+
+
+def _det_from_result(status: int, vals: Tuple[int, ...], origin: str) -> FaceEyesDet:
+    """FaceEyesDet from a ResultatFil (15 x int32) as sent by the daemon / shm ring."""
+    if status != 0:
+        return FaceEyesDet(face_ok=False, eyes_ok=False, raw=f"vision_status:{status} {origin}")
+
+    (face_ok, fx, fy, frx, fry, eyes_ok, ex1, ey1, ex2, ey2, er,
+     edge_face, edge_eye, face_min, eye_min) = vals
+
+    raw = (
+        f"{origin}\n"
+        f"face_ok={face_ok} face=({fx},{fy}) rx={frx} ry={fry}\n"
+        f"eyes_ok={eyes_ok} eyes=({ex1},{ey1}) ({ex2},{ey2}) r={er}\n"
+        f"EDGE_FACE={edge_face} EDGE_EYE={edge_eye} FACE_MIN_SCORE={face_min} EYE_MIN_PEAK={eye_min}"
+    )
+    det = FaceEyesDet(face_ok=bool(face_ok), eyes_ok=bool(eyes_ok), raw=raw)
+    if face_ok:
+        det.face_center = (fx, fy)
+    if eyes_ok:
+        det.eye1 = (ex1, ey1)
+        det.eye2 = (ex2, ey2)
+        det.eye_r = er
+    return det
+
+
+class GhtDaemonClient:
     """
-    Call C++ GHT detector and parse stdout for Face/Eyes.
+    Client for a long-running `ght_face_eyes --serve <socket>`.
 
-      ght_face_eyes --image <path> [--gui] [--no-gui] [--gui-steps] [--gui-delay-ms <N>]
-                   [--no-auto-threshold] [--face-edge v] [--eye-edge v]
-                   [--no-eq] [--clahe] [--blur k]
-                   [--face-min-score v] [--eye-min-peak v]
+    The daemon builds the face/eye model bank once; each request only pays for
+    preprocessing and detection. One connection carries many requests; calls
+    from several threads are serialized. A request that fails part-way (timeout,
+    broken pipe, bad reply) closes the connection, since the stream can no
+    longer be trusted to be in sync.
     """
-    if not image_path or not os.path.exists(image_path):
-        return FaceEyesDet(face_ok=False, eyes_ok=False, raw="image_not_found")
 
-    exe = bin_path or _default_bin_path()
-    if not os.path.exists(exe):
-        return FaceEyesDet(face_ok=False, eyes_ok=False, raw=f"vision_binary_not_found:{exe}")
+    def __init__(self, socket_path: str, timeout_sec: float = 5.0):
+        self.socket_path = socket_path
+        self._lock = threading.Lock()
+        self.closed = False
+        self._sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self._sock.settimeout(timeout_sec)
+        try:
+            self._sock.connect(socket_path)
+        except BaseException:
+            self.close()
+            raise
 
-    cmd: List[str] = [exe, "--image", image_path]
+    def close(self) -> None:
+        self.closed = True
+        try:
+            self._sock.close()
+        except OSError:
+            pass
 
-    # GUI/headless controls
-    if gui or gui_steps or (gui_delay_ms and gui_delay_ms > 0):
-        cmd.append("--gui")
-        if gui_steps:
-            cmd.append("--gui-steps")
-        if gui_delay_ms and gui_delay_ms > 0:
-            cmd.extend(["--gui-delay-ms", str(int(gui_delay_ms))])
-    elif headless:
-        cmd.append("--no-gui")
+    def detect_path(self, image_path: str, **opts) -> FaceEyesDet:
+        return self._request(REQ_PATH, os.fsencode(image_path), opts)
+
+    def detect_encoded(self, data: bytes, **opts) -> FaceEyesDet:
+        return self._request(REQ_ENCODED, data, opts)
+
+    def detect_frame(self, frame, **opts) -> FaceEyesDet:
+        """8-bit BGR (H,W,3) or gray (H,W) array, sent as raw pixels."""
+        hdr, pixels = _frame_header(frame)
+        return self._request(REQ_FRAME, hdr, opts, extra=pixels)
+
+    def _request(
+        self,
+        kind: int,
+        payload: bytes,
+        opts: Dict,
+        extra: Optional[memoryview] = None,
+    ) -> FaceEyesDet:
+        with self._lock:
+            if self.closed:
+                raise ConnectionError("vision daemon: connection closed")
+            try:
+                return self._request_locked(kind, payload, opts, extra)
+            except BaseException:
+                self.close()
+                raise
+
+    def _request_locked(
+        self,
+        kind: int,
+        payload: bytes,
+        opts: Dict,
+        extra: Optional[memoryview],
+    ) -> FaceEyesDet:
+        flags = 0
+        if opts.get("eq_hist", True):
+            flags |= _FLAG_EQ_HIST
+        if opts.get("clahe", False):
+            flags |= _FLAG_CLAHE
+        if opts.get("auto_threshold", True):
+            flags |= _FLAG_AUTO_THR
+
+        def _opt_int(name: str, default: int = -1) -> int:
+            v = opts.get(name)
+            return default if v is None else int(v)
+
+        hdr = _REQ_HDR.pack(
+            _REQ_MAGIC,
+            kind,
+            flags,
+            _opt_int("blur_k", 5),
+            _opt_int("face_edge"),
+            _opt_int("eye_edge"),
+            _opt_int("face_min_score"),
+            _opt_int("eye_min_peak"),
+            len(payload) + (len(extra) if extra is not None else 0),
+        )
+        self._sock.sendall(hdr + payload)
+        if extra is not None:
+            self._sock.sendall(extra)
+
+        magic, status, plen = _RESP_HDR.unpack(_recv_exact(self._sock, _RESP_HDR.size))
+        if magic != _RESP_MAGIC:
+            raise ConnectionError("vision daemon: bad response magic")
+        body = _recv_exact(self._sock, plen) if plen else b""
+        if status != 0 or len(body) < _RESULT.size:
+            return FaceEyesDet(face_ok=False, eyes_ok=False, raw=f"vision_daemon_status:{status}")
+        return _det_from_result(status, _RESULT.unpack_from(body), f"daemon={self.socket_path}")
+
+
+# Shared-memory ring of `ght_face_eyes --shm <name>` (see EnteteAnneau / EnteteSlot / Completion)
+_SHM_MAGIC = 0x53544847  # "GHTS"
+_SHM_HDR = struct.Struct("<9I")
+_SHM_SLOT = struct.Struct("<6I5i")  # EnteteSlot fields after `state`
+_SHM_SLOT_HDR_SIZE = 64
+_SHM_COMPLETION = struct.Struct("<3I15i")
+_SLOT_FREE, _SLOT_READY, _SLOT_BUSY, _SLOT_DONE = 0, 1, 2, 3
+_U32 = struct.Struct("<I")
+
+
+class GhtShmRing:
+    """
+    Producer side of `ght_face_eyes --shm <name>`.
+
+    Frames are written once into a slot of the shared segment (or captured
+    straight into `slot_buffer()`), the detector reads them in place and posts
+    results to the completion queue of the same segment. No socket, no file.
+
+    Ordering relies on plain stores from Python being observed in program order
+    by the detector (true on x86; use the daemon socket on weakly ordered CPUs).
+    """
+
+    def __init__(self, name: str):
+        import mmap
+
+        path = os.path.join("/dev/shm", name.lstrip("/"))
+        fd = os.open(path, os.O_RDWR)
+        try:
+            self._mm = mmap.mmap(fd, 0)
+        finally:
+            os.close(fd)
+        (magic, _version, self.n_slots, self.slot_bytes, self._slots_off,
+         self._slot_stride, self._cq_off, _head, _pid) = _SHM_HDR.unpack_from(self._mm, 0)
+        if magic != _SHM_MAGIC:
+            self._mm.close()
+            raise ValueError(f"not a ght_face_eyes ring: {path}")
+        self._tail = _U32.unpack_from(self._mm, 28)[0]
+        self._seq = 0
+        self._done: Dict[int, FaceEyesDet] = {}
+
+    def close(self) -> None:
+        self._mm.close()
+
+    def _slot_off(self, i: int) -> int:
+        return self._slots_off + i * self._slot_stride
+
+    def _state(self, i: int) -> int:
+        return _U32.unpack_from(self._mm, self._slot_off(i))[0]
+
+    def acquire_slot(self) -> Optional[int]:
+        """Index of a FREE slot, or None when all slots are in flight."""
+        for i in range(self.n_slots):
+            if self._state(i) == _SLOT_FREE:
+                return i
+        return None
+
+    def slot_buffer(self, slot: int) -> memoryview:
+        """Writable pixel area of a slot (e.g. for np.frombuffer + cap.read(image=...))."""
+        off = self._slot_off(slot) + _SHM_SLOT_HDR_SIZE
+        return memoryview(self._mm)[off:off + self.slot_bytes]
+
+    def submit(self, slot: int, width: int, height: int, stride: int, channels: int, **opts) -> int:
+        """
+        Publish pixels already in slot_buffer(slot). Returns the sequence tag.
+        stride may exceed width * channels by at most 64 bytes (row padding).
+        """
+        flags = 0
+        if opts.get("eq_hist", True):
+            flags |= _FLAG_EQ_HIST
+        if opts.get("clahe", False):
+            flags |= _FLAG_CLAHE
+        if opts.get("auto_threshold", True):
+            flags |= _FLAG_AUTO_THR
+
+        def _opt_int(name: str, default: int = -1) -> int:
+            v = opts.get(name)
+            return default if v is None else int(v)
+
+        self._seq = (self._seq + 1) & 0xFFFFFFFF
+        _SHM_SLOT.pack_into(
+            self._mm, self._slot_off(slot) + 4,
+            self._seq, width, height, stride, channels, flags,
+            _opt_int("blur_k", 5), _opt_int("face_edge"), _opt_int("eye_edge"),
+            _opt_int("face_min_score"), _opt_int("eye_min_peak"),
+        )
+        _U32.pack_into(self._mm, self._slot_off(slot), _SLOT_READY)  # publish last
+        return self._seq
+
+    def submit_frame(self, frame, **opts) -> Optional[int]:
+        """Copy an 8-bit gray/BGR array into a free slot and publish it (None if ring full)."""
+        slot = self.acquire_slot()
+        if slot is None:
+            return None
+        hdr, pixels = _frame_header(frame)
+        w, h, stride, ch = struct.unpack("<4I", hdr)
+        if len(pixels) > self.slot_bytes:
+            raise ValueError("frame larger than the ring slots")
+        self.slot_buffer(slot)[:len(pixels)] = pixels
+        return self.submit(slot, w, h, stride, ch, **opts)
+
+    def poll(self) -> None:
+        """Drain the completion queue and release the corresponding slots."""
+        head = _U32.unpack_from(self._mm, 28)[0]
+        while self._tail != head:
+            off = self._cq_off + (self._tail % self.n_slots) * _SHM_COMPLETION.size
+            vals = _SHM_COMPLETION.unpack_from(self._mm, off)
+            seq, slot, status = vals[0], vals[1], vals[2]
+            self._done[seq] = _det_from_result(status, vals[3:], f"shm_slot={slot}")
+            _U32.pack_into(self._mm, self._slot_off(slot), _SLOT_FREE)
+            self._tail = (self._tail + 1) & 0xFFFFFFFF
+
+    def wait(self, seq: int, timeout_sec: float = 5.0) -> FaceEyesDet:
+        import time
+
+        deadline = time.monotonic() + timeout_sec
+        while True:
+            self.poll()
+            det = self._done.pop(seq, None)
+            if det is not None:
+                return det
+            if time.monotonic() > deadline:
+                return FaceEyesDet(face_ok=False, eyes_ok=False, raw="vision_timeout")
+            time.sleep(0.0002)
+
+    def detect(self, frame, timeout_sec: float = 5.0, **opts) -> FaceEyesDet:
+        seq = self.submit_frame(frame, **opts)
+        if seq is None:
+            self.poll()
+            seq = self.submit_frame(frame, **opts)
+            if seq is None:
+                return FaceEyesDet(face_ok=False, eyes_ok=False, raw="vision_ring_full")
+        return self.wait(seq, timeout_sec)
+
+
+# one persistent connection per daemon socket (reconnected once closed)
+_daemon_clients: Dict[str, GhtDaemonClient] = {}
+_daemon_clients_lock = threading.Lock()
+
+
+def _daemon_client(socket_path: str, timeout_sec: float) -> GhtDaemonClient:
+    with _daemon_clients_lock:
+        cli = _daemon_clients.get(socket_path)
+        if cli is None or cli.closed:
+            cli = GhtDaemonClient(socket_path, timeout_sec=timeout_sec)
+            _daemon_clients[socket_path] = cli
+        return cli
+
+
+def _drop_daemon_client(socket_path: str) -> None:
+    with _daemon_clients_lock:
+        cli = _daemon_clients.pop(socket_path, None)
+    if cli is not None:
+        cli.close()
+
+
+def _frame_header(frame) -> Tuple[bytes, memoryview]:
+    """
+    Raw frame header (u32 width, height, stride, channels) + pixel buffer for an
+    8-bit gray (H,W) / BGR (H,W,3) array. C-contiguous arrays are sent as-is.
+    """
+    mv = memoryview(frame)
+    if mv.format not in ("B", "b") or mv.ndim not in (2, 3):
+        raise ValueError("frame must be an 8-bit (H,W) or (H,W,3) array")
+    h, w = mv.shape[0], mv.shape[1]
+    ch = mv.shape[2] if mv.ndim == 3 else 1
+    if ch not in (1, 3):
+        raise ValueError("frame must have 1 or 3 channels")
+    if not mv.c_contiguous:
+        mv = memoryview(mv.tobytes())
+    return struct.pack("<4I", w, h, w * ch, ch), mv.cast("B")
+
+
+def _detector_flags(
+    auto_threshold: bool,
+    face_edge: Optional[int],
+    eye_edge: Optional[int],
+    face_min_score: Optional[int],
+    eye_min_peak: Optional[int],
+    eq_hist: bool,
+    clahe: bool,
+    blur_k: Optional[int],
+) -> List[str]:
+    cmd: List[str] = []
 
     # preprocessing flags
     if not auto_threshold:
@@ -97,12 +419,15 @@ def detect_face_eyes_by_ght(
         cmd.extend(["--face-min-score", str(int(face_min_score))])
     if eye_min_peak is not None:
         cmd.extend(["--eye-min-peak", str(int(eye_min_peak))])
+    return cmd
+
 
+def _run_detector(cmd: List[str], timeout_sec: int, stdin_data: Optional[bytes] = None) -> FaceEyesDet:
     try:
         cp = subprocess.run(
             cmd,
+            input=stdin_data,
             capture_output=True,
-            text=True,
             timeout=timeout_sec,
             check=False,
         )
@@ -111,8 +436,8 @@ def detect_face_eyes_by_ght(
     except Exception as e:
         return FaceEyesDet(face_ok=False, eyes_ok=False, raw=f"vision_exec_error:{e}")
 
-    out = (cp.stdout or "").strip()
-    err = (cp.stderr or "").strip()
+    out = (cp.stdout or b"").decode("utf-8", "replace").strip()
+    err = (cp.stderr or b"").decode("utf-8", "replace").strip()
 
     raw = (
         f"cmd={cmd}\n"
@@ -145,3 +470,154 @@ def detect_face_eyes_by_ght(
         det.eye_r = int(em.group(5))
 
     return det
+
+
+def detect_face_eyes_by_ght(
+    image_path: str,
+    bin_path: Optional[str] = None,
+    timeout_sec: int = 5,
+    headless: bool = True,
+    gui: bool = False,
+    gui_steps: bool = False,
+    gui_delay_ms: int = 0,
+    # New knobs (optional)
+    auto_threshold: bool = True,
+    face_edge: Optional[int] = None,
+    eye_edge: Optional[int] = None,
+    face_min_score: Optional[int] = None,
+    eye_min_peak: Optional[int] = None,
+    eq_hist: bool = True,
+    clahe: bool = False,
+    blur_k: int = 5,
+    socket_path: Optional[str] = None,
+) -> FaceEyesDet:
+    """
+    Call C++ GHT detector and parse stdout for Face/Eyes.
+
+    If `socket_path` (or $GHT_FACE_EYES_SOCKET) points to a running
+    `ght_face_eyes --serve <socket>`, the request goes to that daemon instead of
+    spawning a process; on connection errors we fall back to the subprocess.
+
+      ght_face_eyes --image <path> [--gui] [--no-gui] [--gui-steps] [--gui-delay-ms <N>]
+                   [--no-auto-threshold] [--face-edge v] [--eye-edge v]
+                   [--no-eq] [--clahe] [--blur k]
+                   [--face-min-score v] [--eye-min-peak v]
+    """
+    if not image_path or not os.path.exists(image_path):
+        return FaceEyesDet(face_ok=False, eyes_ok=False, raw="image_not_found")
+
+    sock_path = socket_path or os.environ.get(_SOCKET_ENV)
+    want_gui = gui or gui_steps or (gui_delay_ms and gui_delay_ms > 0)
+    if sock_path and not want_gui:
+        try:
+            return _daemon_client(sock_path, timeout_sec).detect_path(
+                image_path,
+                auto_threshold=auto_threshold,
+                face_edge=face_edge,
+                eye_edge=eye_edge,
+                face_min_score=face_min_score,
+                eye_min_peak=eye_min_peak,
+                eq_hist=eq_hist,
+                clahe=clahe,
+                blur_k=blur_k,
+            )
+        except OSError:
+            _drop_daemon_client(sock_path)
+
+    exe = bin_path or _default_bin_path()
+    if not os.path.exists(exe):
+        return FaceEyesDet(face_ok=False, eyes_ok=False, raw=f"vision_binary_not_found:{exe}")
+
+    cmd: List[str] = [exe, "--image", image_path]
+
+    # GUI/headless controls
+    if want_gui:
+        cmd.append("--gui")
+        if gui_steps:
+            cmd.append("--gui-steps")
+        if gui_delay_ms and gui_delay_ms > 0:
+            cmd.extend(["--gui-delay-ms", str(int(gui_delay_ms))])
+    elif headless:
+        cmd.append("--no-gui")
+
+    cmd.extend(_detector_flags(auto_threshold, face_edge, eye_edge, face_min_score, eye_min_peak,
+                               eq_hist, clahe, blur_k))
+    return _run_detector(cmd, timeout_sec)
+
+
+def detect_face_eyes_from_array(
+    frame,
+    bin_path: Optional[str] = None,
+    timeout_sec: int = 5,
+    auto_threshold: bool = True,
+    face_edge: Optional[int] = None,
+    eye_edge: Optional[int] = None,
+    face_min_score: Optional[int] = None,
+    eye_min_peak: Optional[int] = None,
+    eq_hist: bool = True,
+    clahe: bool = False,
+    blur_k: int = 5,
+    socket_path: Optional[str] = None,
+) -> FaceEyesDet:
+    """
+    Same as detect_face_eyes_by_ght, but for an in-memory 8-bit BGR (H,W,3) or
+    gray (H,W) frame. No PNG encode/decode, no temp file. In order of preference:
+      - the _ght extension (in-process, reads the array in place, GIL released)
+      - a daemon (request kind 3)
+      - `ght_face_eyes --raw-stdin`
+    """
+    if frame is None:
+        return FaceEyesDet(face_ok=False, eyes_ok=False, raw="frame_empty")
+
+    native = _load_native_detector() if bin_path is None else None
+    r = None
+    if native is not None:
+        try:
+            r = native.detect(
+                frame,
+                equalize=eq_hist,
+                clahe=clahe,
+                blur_k=5 if blur_k is None else int(blur_k),
+                auto_threshold=auto_threshold,
+                face_edge=-1 if face_edge is None else int(face_edge),
+                eye_edge=-1 if eye_edge is None else int(eye_edge),
+                face_min_score=-1 if face_min_score is None else int(face_min_score),
+                eye_min_peak=-1 if eye_min_peak is None else int(eye_min_peak),
+            )
+        except (TypeError, ValueError) as e:
+            return FaceEyesDet(face_ok=False, eyes_ok=False, raw=f"frame_invalid:{e}")
+        except (RuntimeError, MemoryError, BufferError, OverflowError):
+            # detector failure (ght_detect error, allocation, buffer export): daemon/subprocess
+            r = None
+    if r is not None:
+        return _det_from_result(0, tuple(r), "native=_ght")
+    try:
+        hdr, pixels = _frame_header(frame)
+    except (TypeError, ValueError) as e:
+        return FaceEyesDet(face_ok=False, eyes_ok=False, raw=f"frame_invalid:{e}")
+
+    opts = dict(
+        auto_threshold=auto_threshold,
+        face_edge=face_edge,
+        eye_edge=eye_edge,
+        face_min_score=face_min_score,
+        eye_min_peak=eye_min_peak,
+        eq_hist=eq_hist,
+        clahe=clahe,
+        blur_k=blur_k,
+    )
+
+    sock_path = socket_path or os.environ.get(_SOCKET_ENV)
+    if sock_path:
+        try:
+            return _daemon_client(sock_path, timeout_sec).detect_frame(frame, **opts)
+        except OSError:
+            _drop_daemon_client(sock_path)
+
+    exe = bin_path or _default_bin_path()
+    if not os.path.exists(exe):
+        return FaceEyesDet(face_ok=False, eyes_ok=False, raw=f"vision_binary_not_found:{exe}")
+
+    cmd: List[str] = [exe, "--raw-stdin", "--no-gui"]
+    cmd.extend(_detector_flags(**opts))
+    return _run_detector(cmd, timeout_sec, stdin_data=hdr + pixels.tobytes())
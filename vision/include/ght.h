@@ -0,0 +1,92 @@
+/* FILE: vision/include/ght.h
+ *
+ * libght: C API of the GHT face/eyes detector (same engine as ght_face_eyes).
+ *
+ *   ght_detector* d = ght_detector_create();        // builds the model bank once
+ *   ght_result r;
+ *   ght_detect(d, pixels, w, h, stride, 3, NULL, &r); // caller-owned BGR or gray buffer
+ *   ght_detector_free(d);
+ *
+ * The model bank is read-only after creation: one detector may be used from
+ * several threads at the same time. Pixels are only read, never retained.
+ */
+#ifndef GHT_H
+#define GHT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(GHT_BUILDING)
+#    define GHT_API __declspec(dllexport)
+#  else
+#    define GHT_API
+#  endif
+#else
+#  define GHT_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GHT_API_VERSION 1
+
+enum {
+    GHT_OK           = 0,
+    GHT_ERR_ARG      = -1, /* null pointer, bad size/stride/channel count */
+    GHT_ERR_ALLOC    = -2,
+    GHT_ERR_INTERNAL = -3
+};
+
+typedef struct ght_detector ght_detector;
+
+/* Preprocessing + thresholds, same meaning as the ght_face_eyes options. */
+typedef struct ght_params {
+    int32_t equalize;        /* equalizeHist (default 1) */
+    int32_t clahe;           /* CLAHE instead of equalizeHist (default 0) */
+    int32_t blur_k;          /* gaussian kernel, odd; 0 disables (default 5) */
+    int32_t auto_threshold;  /* percentile-based edge thresholds (default 1) */
+    int32_t face_edge;       /* -1 = default / auto */
+    int32_t eye_edge;        /* -1 = default / auto */
+    int32_t face_min_score;  /* -1 = default */
+    int32_t eye_min_peak;    /* -1 = default */
+} ght_params;
+
+typedef struct ght_result {
+    int32_t face_ok;
+    int32_t face_x, face_y, face_rx, face_ry;
+    int32_t eyes_ok;
+    int32_t eye1_x, eye1_y, eye2_x, eye2_y, eye_r;
+    /* thresholds actually used */
+    int32_t edge_face, edge_eye, face_min_score, eye_min_peak;
+} ght_result;
+
+GHT_API int ght_api_version(void);
+
+GHT_API void ght_params_default(ght_params* params);
+
+/* NULL on allocation failure. */
+GHT_API ght_detector* ght_detector_create(void);
+
+GHT_API void ght_detector_free(ght_detector* detector);
+
+/* pixels: height rows of `stride` bytes, 8-bit gray (channels = 1) or BGR (channels = 3),
+ * width and height at most 32767 (GHT_ERR_ARG above).
+ * params may be NULL (defaults). Returns GHT_OK or a negative GHT_ERR_* code. */
+GHT_API int ght_detect(
+    const ght_detector* detector,
+    const uint8_t* pixels,
+    int width,
+    int height,
+    size_t stride,
+    int channels,
+    const ght_params* params,
+    ght_result* out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GHT_H */
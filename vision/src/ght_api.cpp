@@ -0,0 +1,108 @@
+// FILE: vision/src/ght_api.cpp
+// C API of libght (include/ght.h) on top of the detection core.
+#include "ght.h"
+#include "ght_core.hpp"
+
+#include <new>
+
+struct ght_detector {
+    BanqueModeles banque;
+};
+
+static OptionsDetection optionsDepuisParams(const ght_params& p) {
+    OptionsDetection opt;
+    opt.useEqHist = p.equalize != 0;
+    opt.useClahe = p.clahe != 0;
+    opt.blurK = p.blur_k;
+    opt.autoThr = p.auto_threshold != 0;
+    opt.faceEdgeUser = p.face_edge;
+    opt.eyeEdgeUser = p.eye_edge;
+    opt.faceMinUser = p.face_min_score;
+    opt.eyeMinUser = p.eye_min_peak;
+    return opt;
+}
+
+extern "C" {
+
+int ght_api_version(void) {
+    return GHT_API_VERSION;
+}
+
+void ght_params_default(ght_params* params) {
+    if (!params) return;
+    OptionsDetection opt;
+    params->equalize = opt.useEqHist ? 1 : 0;
+    params->clahe = opt.useClahe ? 1 : 0;
+    params->blur_k = opt.blurK;
+    params->auto_threshold = opt.autoThr ? 1 : 0;
+    params->face_edge = opt.faceEdgeUser;
+    params->eye_edge = opt.eyeEdgeUser;
+    params->face_min_score = opt.faceMinUser;
+    params->eye_min_peak = opt.eyeMinUser;
+}
+
+ght_detector* ght_detector_create(void) {
+    try {
+        ght_detector* d = new ght_detector();
+        d->banque = construireBanqueModeles();
+        return d;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void ght_detector_free(ght_detector* detector) {
+    delete detector;
+}
+
+int ght_detect(
+    const ght_detector* detector,
+    const uint8_t* pixels,
+    int width,
+    int height,
+    size_t stride,
+    int channels,
+    const ght_params* params,
+    ght_result* out
+) {
+    if (!detector || !pixels || !out) return GHT_ERR_ARG;
+    if (width <= 0 || height <= 0 || !tailleImageValide(width, height)) return GHT_ERR_ARG;
+    if (channels != 1 && channels != 3) return GHT_ERR_ARG;
+    if (stride < (size_t)width * (size_t)channels) return GHT_ERR_ARG;
+
+    ght_params p;
+    if (params) p = *params;
+    else ght_params_default(&p);
+
+    try {
+        // header over the caller's buffer: gray input is read in place, never written
+        cv::Mat src(height, width, channels == 3 ? CV_8UC3 : CV_8UC1, const_cast<uint8_t*>(pixels), stride);
+        Seuils seuils;
+        // buffers reused across this thread's calls (no engine pool here, so no re-entry)
+        thread_local EspaceTravail ws;
+        faceeyes r = analyser(src, detector->banque, optionsDepuisParams(p), seuils, nullptr, false, nullptr, &ws);
+
+        out->face_ok = r.faceOk ? 1 : 0;
+        out->face_x = r.faceX;
+        out->face_y = r.faceY;
+        out->face_rx = r.faceRx;
+        out->face_ry = r.faceRy;
+        out->eyes_ok = r.eyesOk ? 1 : 0;
+        out->eye1_x = r.ex1;
+        out->eye1_y = r.ey1;
+        out->eye2_x = r.ex2;
+        out->eye2_y = r.ey2;
+        out->eye_r = r.eyeR;
+        out->edge_face = seuils.edgeFace;
+        out->edge_eye = seuils.edgeEye;
+        out->face_min_score = seuils.faceMinScore;
+        out->eye_min_peak = seuils.eyeMinPeak;
+        return GHT_OK;
+    } catch (const std::bad_alloc&) {
+        return GHT_ERR_ALLOC;
+    } catch (...) {
+        return GHT_ERR_INTERNAL;
+    }
+}
+
+} // extern "C"
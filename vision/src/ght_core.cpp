@@ -0,0 +1,1909 @@
+// FILE: vision/src/ght_core.cpp
+#include "ght_core.hpp"
+#include "ght_pool.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <utility>
+
+using Horloge = std::chrono::steady_clock;
+
+static void noterEtape(MesuresDetection* m, const char* etape, const char* cible, int modele,
+                       Horloge::time_point t0, uint64_t bords = 0, uint64_t votes = 0, uint64_t cellules = 0) {
+    if (!m) return;
+    MesureEtape e;
+    e.etape = etape;
+    e.cible = cible;
+    e.modele = modele;
+    e.us = std::chrono::duration<double, std::micro>(Horloge::now() - t0).count();
+    e.bords = bords;
+    e.votes = votes;
+    e.cellules = cellules;
+    m->etapes.push_back(e);
+}
+
+static void fusionnerMesures(MesuresDetection& dst, const MesuresDetection& src) {
+    dst.etapes.insert(dst.etapes.end(), src.etapes.begin(), src.etapes.end());
+}
+
+// Runs f(0..n-1) on the engine pool when there is one, inline otherwise.
+template <typename F>
+static void pourChaqueModele(const OptionsMoteur& moteur, size_t n, const F& f) {
+    if (moteur.pool) {
+        moteur.pool->executerParallele(n, f);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) f(i);
+}
+
+// Face scales voted under OptionsMoteur::pasEchelles (models ordered by size): every
+// pas-th one and the largest, then probes around the current best (the last of the
+// highest peaks, as the pickers below). voterModele(mi) fills the result of model mi,
+// pic(mi) reads its peak back (0 = none); vote marks the voted models, lot is scratch.
+template <typename Voter, typename Pic>
+static void voterEchelles(const OptionsMoteur& moteur, size_t n, std::vector<char>& vote, std::vector<size_t>& lot,
+                          const Voter& voterModele, const Pic& pic) {
+    vote.assign(n, 0);
+    const size_t pas = moteur.pasEchelles > 1 ? (size_t)moteur.pasEchelles : 1;
+    lot.clear();
+    for (size_t mi = 0; mi < n; mi += pas) lot.push_back(mi);
+    if (n > 0 && lot.back() != n - 1) lot.push_back(n - 1);
+
+    auto voterLot = [&]() {
+        pourChaqueModele(moteur, lot.size(), [&](size_t i) { voterModele(lot[i]); });
+        for (size_t mi : lot) vote[mi] = 1;
+    };
+    auto meilleur = [&]() {
+        int m = -1;
+        uint16_t p = 0;
+        for (size_t mi = 0; mi < n; ++mi) {
+            if (vote[mi] && pic(mi) > 0 && pic(mi) >= p) { p = pic(mi); m = (int)mi; }
+        }
+        return m;
+    };
+
+    voterLot();
+    if (pas == 1) return;
+    // probes at m +- d with d halving from pas / 2, then +-1 steps while the best moves
+    size_t d = std::max<size_t>(1, pas / 2);
+    for (int m = meilleur(); m >= 0;) {
+        lot.clear();
+        if ((size_t)m >= d && !vote[(size_t)m - d]) lot.push_back((size_t)m - d);
+        if ((size_t)m + d < n && !vote[(size_t)m + d]) lot.push_back((size_t)m + d);
+        if (!lot.empty()) voterLot();
+        const int suivant = meilleur();
+        if (d > 1) d /= 2;
+        else if (suivant == m) break;
+        m = suivant;
+    }
+}
+
+// -------------------- image struct --------------------
+static grayImage makeGris(int w, int h, uint8_t value) {
+    grayImage g;
+    g.w = w;
+    g.h = h;
+    g.p.assign((size_t)w * (size_t)h, value);
+    return g;
+}
+
+grayView vue(const grayImage& g) {
+    return grayView{g.w, g.h, (size_t)g.w, g.p.data()};
+}
+
+grayView sousVue(const grayView& g, int x0, int y0, int w, int h) {
+    return grayView{w, h, g.stride, g.p + (size_t)y0 * g.stride + (size_t)x0};
+}
+
+grayView matToGrayView(const cv::Mat& grayU8) {
+    return grayView{grayU8.cols, grayU8.rows, (size_t)grayU8.step, grayU8.ptr<uint8_t>(0)};
+}
+
+// -------------------- pyramid --------------------
+grayImage reduireImage(const grayView& img, int facteur) {
+    grayImage r;
+    reduireImage(img, facteur, r);
+    return r;
+}
+
+void reduireImage(const grayView& img, int facteur, grayImage& r) {
+    r.w = img.w / facteur;
+    r.h = img.h / facteur;
+    r.p.resize((size_t)r.w * (size_t)r.h);
+    const uint32_t n = (uint32_t)(facteur * facteur);
+    for (int y = 0; y < r.h; ++y) {
+        const uint8_t* ligne = img.p + (size_t)(y * facteur) * img.stride;
+        for (int x = 0; x < r.w; ++x) {
+            uint32_t somme = 0;
+            for (int dy = 0; dy < facteur; ++dy) {
+                for (int dx = 0; dx < facteur; ++dx) somme += ligne[(size_t)dy * img.stride + (size_t)(x * facteur + dx)];
+            }
+            r.at(y, x) = (uint8_t)((somme + n / 2) / n);
+        }
+    }
+}
+
+// For GUI: normalize magnitude to [0..255] by min/max (readable even when edges are weak)
+// -------------------- accumulator + R-Table --------------------
+AccuImage makeAccu(int w, int h) {
+    AccuImage A;
+    preparerAccu(A, w, h);
+    return A;
+}
+
+void preparerAccu(AccuImage& A, int w, int h) {
+    A.w = w; A.h = h;
+    A.a.assign((size_t)w * (size_t)h, 0);
+}
+
+VolumeAccu makeVolume(int w, int h, int n) {
+    VolumeAccu V;
+    preparerVolume(V, w, h, n);
+    return V;
+}
+
+void preparerVolume(VolumeAccu& V, int w, int h, int n) {
+    V.w = w; V.h = h; V.n = n;
+    V.plans.resize((size_t)std::max(n, 0));
+    for (AccuImage& A : V.plans) preparerAccu(A, w, h);
+}
+
+RTable rtableDepuisListes(const ListesRTable& bins) {
+    RTable rt;
+    bool premier = true;
+    for (size_t b = 0; b < 360; ++b) {
+        rt.debut[b + 1] = rt.debut[b] + (uint32_t)bins[b].size();
+        bool vide = true;
+        for (const auto& d : bins[b]) {
+            rt.dx.push_back(d.first);
+            rt.dy.push_back(d.second);
+            if (vide) {
+                rt.dxMin[b] = rt.dxMax[b] = d.first;
+                rt.dyMin[b] = rt.dyMax[b] = d.second;
+                vide = false;
+            }
+            rt.dxMin[b] = std::min(rt.dxMin[b], d.first);
+            rt.dxMax[b] = std::max(rt.dxMax[b], d.first);
+            rt.dyMin[b] = std::min(rt.dyMin[b], d.second);
+            rt.dyMax[b] = std::max(rt.dyMax[b], d.second);
+        }
+        if (vide) continue;
+        if (premier) {
+            rt.dxMinModele = rt.dxMin[b]; rt.dxMaxModele = rt.dxMax[b];
+            rt.dyMinModele = rt.dyMin[b]; rt.dyMaxModele = rt.dyMax[b];
+            premier = false;
+        }
+        rt.dxMinModele = std::min(rt.dxMinModele, rt.dxMin[b]);
+        rt.dxMaxModele = std::max(rt.dxMaxModele, rt.dxMax[b]);
+        rt.dyMinModele = std::min(rt.dyMinModele, rt.dyMin[b]);
+        rt.dyMaxModele = std::max(rt.dyMaxModele, rt.dyMax[b]);
+    }
+    return rt;
+}
+
+// saturating +1 without a branch
+static inline void incrementer(uint16_t* cell) {
+    *cell = (uint16_t)(*cell + (*cell != 65535));
+}
+
+// Vote trackers: SansSuivi only counts; SuiviCourant also keeps the running max of the
+// buffer (branch-free, one op per vote, in 32 bits to avoid partial-register merges)
+// and, with kListe, the cells whose count reaches seuil (each crosses once: votes are
+// +1). Tracking the max location per vote costs more in the vote loop than the scan it
+// replaces; dernierEgal() finds it afterwards instead.
+struct SansSuivi {
+    void voter(uint16_t* acc, size_t i) { incrementer(acc + i); }
+};
+
+template <bool kListe>
+struct SuiviCourant {
+    uint32_t pic = 0;
+    uint32_t seuil = 0;
+    std::vector<uint32_t>* auDessus = nullptr;
+
+    void voter(uint16_t* acc, size_t i) {
+        const uint32_t ancien = acc[i];
+        const uint32_t nouveau = ancien + (ancien != 65535);
+        acc[i] = (uint16_t)nouveau;
+        pic = std::max(pic, nouveau);
+        if (kListe && ancien + 1 == seuil) auDessus->push_back((uint32_t)i);
+    }
+};
+
+// Index of the last cell equal to v (the raster-last max when v is the max), n - 1 if
+// none. Blocks are tested with a branch-free compare that vectorizes; the scan stops at
+// the first block holding v, so only the cells after the peak are read.
+static size_t dernierEgal(const uint16_t* a, size_t n, uint16_t v) {
+    static const size_t kBloc = 64;
+    size_t fin = n;
+    while (fin > 0) {
+        const size_t debut = fin >= kBloc ? fin - kBloc : 0;
+        int trouve = 0;
+        for (size_t i = debut; i < fin; ++i) trouve |= (a[i] == v);
+        if (trouve) {
+            for (size_t i = fin; i-- > debut;) {
+                if (a[i] == v) return i;
+            }
+        }
+        fin = debut;
+    }
+    return n ? n - 1 : 0;
+}
+
+// Votes of offsets [k0, k1) from (x, y), bounds-checked against the w x h accumulator
+// (footprint crosses the border). acc holds its rows from yOrigine on.
+template <typename Suivi>
+static inline uint64_t voterVerifie(Suivi& suivi, uint16_t* acc, int w, int h, int yOrigine,
+                                   const RTable& rt, uint32_t k0, uint32_t k1, int x, int y) {
+    uint64_t votes = 0;
+    for (uint32_t k = k0; k < k1; ++k) {
+        int cx = x + rt.dx[k];
+        int cy = y + rt.dy[k];
+        if (cx < 0 || cy < 0 || cx >= w || cy >= h) continue;
+        suivi.voter(acc, (size_t)(cy - yOrigine) * (size_t)w + (size_t)cx);
+        votes++;
+    }
+    return votes;
+}
+
+// Voting loop for one magnitude representation; passe(i) tells whether pixel i is an edge.
+template <typename Passe>
+static void voterSi(
+    AccuImage& A,
+    const VueGradient& grads,
+    const RTable& rtable,
+    Passe passe,
+    uint64_t& bords,
+    uint64_t& votes
+) {
+    SansSuivi sansSuivi;
+    for (int y = 0; y < grads.h; ++y) {
+        for (int x = 0; x < grads.w; ++x) {
+            const size_t i = (size_t)y * grads.stride + (size_t)x;
+            if (!passe(i)) continue;
+            bords++;
+            const size_t b = grads.ang[i];
+            const uint32_t k0 = rtable.debut[b], k1 = rtable.debut[b + 1];
+            if (k0 == k1) continue;
+
+            const bool interieur = x + rtable.dxMin[b] >= 0 && x + rtable.dxMax[b] < A.w &&
+                                   y + rtable.dyMin[b] >= 0 && y + rtable.dyMax[b] < A.h;
+            if (!interieur) {
+                votes += voterVerifie(sansSuivi, A.a.data(), A.w, A.h, 0, rtable, k0, k1, x, y);
+                continue;
+            }
+            const ptrdiff_t base = (ptrdiff_t)y * A.w + x;
+            for (uint32_t k = k0; k < k1; ++k) {
+                incrementer(&A.a[(size_t)(base + (ptrdiff_t)rtable.dy[k] * A.w + rtable.dx[k])]);
+            }
+            votes += k1 - k0;
+        }
+    }
+}
+
+ListeBords extraireBords(const VueGradient& grads, uint16_t seuilMag) {
+    ListeBords L;
+    std::vector<BordBrut> brut;
+    brut.reserve((size_t)grads.w * (size_t)grads.h / 4);
+    extraireBords(grads, seuilMag, L, brut);
+    return L;
+}
+
+void extraireBords(const VueGradient& grads, uint16_t seuilMag, ListeBords& L, std::vector<BordBrut>& brut) {
+    L.w = grads.w;
+    L.h = grads.h;
+    L.nBandes = (grads.h + kHauteurBandeBords - 1) / kHauteurBandeBords;
+    const size_t nGroupes = (size_t)L.nBandes * 360;
+
+    // raster scan into a scratch list, then a counting sort on (band, bin): debut counts
+    // group sizes, becomes the group ends while placing, and is shifted back to the starts
+    brut.clear();
+    std::vector<uint32_t>& pos = L.debut;
+    pos.assign(nGroupes + 1, 0);
+    auto ajouter = [&](size_t i, int x, int y) {
+        const uint32_t g = (uint32_t)(y / kHauteurBandeBords) * 360u + grads.ang[i];
+        brut.push_back(BordBrut{(int16_t)x, (int16_t)y, g});
+        pos[(size_t)g + 1]++;
+    };
+    if (grads.mag2) {
+        const uint32_t lim = seuilCarre(seuilMag);
+        for (int y = 0; y < grads.h; ++y) {
+            const size_t r = (size_t)y * grads.stride;
+            for (int x = 0; x < grads.w; ++x) if (grads.mag2[r + (size_t)x] >= lim) ajouter(r + (size_t)x, x, y);
+        }
+    } else {
+        for (int y = 0; y < grads.h; ++y) {
+            const size_t r = (size_t)y * grads.stride;
+            for (int x = 0; x < grads.w; ++x) if (grads.mag[r + (size_t)x] >= seuilMag) ajouter(r + (size_t)x, x, y);
+        }
+    }
+
+    for (size_t g = 0; g < nGroupes; ++g) pos[g + 1] += pos[g];
+    L.x.resize(brut.size());
+    L.y.resize(brut.size());
+    for (const BordBrut& p : brut) {
+        const uint32_t k = pos[p.g]++;
+        L.x[k] = p.x;
+        L.y[k] = p.y;
+    }
+    for (size_t g = nGroupes; g > 0; --g) pos[g] = pos[g - 1];
+    pos[0] = 0;
+}
+
+// Votes of bands [bande0, bande1) of the list into acc, a buffer holding the rows
+// [yOrigine, ...) of a w x h accumulator (the accumulator itself when yOrigine = 0).
+//
+// Group by group: one offset against every pixel of the group (saturating +1s commute,
+// so the accumulator matches a per-pixel raster pass). Pixels whose footprint for this
+// bin lies inside the accumulator are split off once per group and vote unchecked
+// through a linear offset; the others keep the bounds-checked path, as do all pixels
+// when the buffer has more cells than a uint32_t index reaches.
+template <typename Suivi>
+static uint64_t voterBandes(Suivi& suiviSortie, uint16_t* acc, int w, int h, int yOrigine,
+                            const ListeBords& bords, const RTable& rtable, int bande0, int bande1,
+                            std::vector<uint32_t>* tampon = nullptr) {
+    Suivi suivi = suiviSortie;  // local copy: stores to acc cannot alias it, stays in registers
+    uint64_t votes = 0;
+    const int16_t* xs = bords.x.data();
+    const int16_t* ys = bords.y.data();
+    uint32_t maxGroupe = 0;
+    for (size_t g = (size_t)bande0 * 360; g < (size_t)bande1 * 360; ++g) {
+        maxGroupe = std::max(maxGroupe, bords.debut[g + 1] - bords.debut[g]);
+    }
+    std::vector<uint32_t> local;
+    std::vector<uint32_t>& groupes = tampon ? *tampon : local;
+    groupes.resize(2 * (size_t)maxGroupe);
+    uint32_t* lin = groupes.data();                  // (y - yOrigine) * w + x of interior pixels
+    uint32_t* aVerifier = lin + maxGroupe;      // indices of border pixels
+    const bool indexable = (uint64_t)std::max(0, h - yOrigine) * (uint64_t)std::max(0, w) <= UINT32_MAX;
+
+    for (int bande = bande0; bande < bande1; ++bande) {
+        const uint32_t* debut = bords.debut.data() + (size_t)bande * 360;
+        for (size_t b = 0; b < 360; ++b) {
+            const uint32_t k0 = rtable.debut[b], k1 = rtable.debut[b + 1];
+            const uint32_t i0 = debut[b], i1 = debut[b + 1];
+            if (k0 == k1 || i0 == i1) continue;
+
+            const int xMin = -rtable.dxMin[b], xMax = w - 1 - rtable.dxMax[b];
+            const int yMin = -rtable.dyMin[b], yMax = h - 1 - rtable.dyMax[b];
+            uint32_t nInt = 0, nBord = 0;
+            for (uint32_t i = i0; i < i1; ++i) {
+                const int x = xs[i], y = ys[i];
+                if (indexable && x >= xMin && x <= xMax && y >= yMin && y <= yMax) {
+                    lin[nInt++] = (uint32_t)((size_t)(y - yOrigine) * (size_t)w + (size_t)x);
+                }
+                else aVerifier[nBord++] = i;
+            }
+
+            for (uint32_t k = k0; k < k1; ++k) {
+                const ptrdiff_t o = (ptrdiff_t)rtable.dy[k] * w + rtable.dx[k];
+                for (uint32_t i = 0; i < nInt; ++i) suivi.voter(acc, (size_t)((ptrdiff_t)lin[i] + o));
+            }
+            votes += (uint64_t)nInt * (k1 - k0);
+            for (uint32_t i = 0; i < nBord; ++i) {
+                votes += voterVerifie(suivi, acc, w, h, yOrigine, rtable, k0, k1, xs[aVerifier[i]], ys[aVerifier[i]]);
+            }
+        }
+    }
+    suiviSortie = suivi;
+    return votes;
+}
+
+void voter(
+    AccuImage& A,
+    const ListeBords& bords,
+    const RTable& rtable,
+    uint64_t* nVotes,
+    PoolTaches* pool,
+    int tuiles,
+    SuiviPic* suivi,
+    TamponVote* tampon
+) {
+    TamponVote local;
+    TamponVote& scratch = tampon ? *tampon : local;
+    if (suivi) {
+        suivi->peak = 0;
+        suivi->px = A.w - 1;
+        suivi->py = A.h - 1;
+        suivi->auDessus.clear();
+    }
+    const int nTuiles = std::min(std::max(1, tuiles), bords.nBandes);
+    if (!pool || nTuiles <= 1) {
+        uint64_t votes = 0;
+        if (suivi) {
+            uint32_t pic = 0;
+            if (suivi->seuil) {
+                SuiviCourant<true> courant;
+                courant.seuil = suivi->seuil;
+                courant.auDessus = &suivi->auDessus;
+                votes = voterBandes(courant, A.a.data(), A.w, A.h, 0, bords, rtable, 0, bords.nBandes, &scratch.groupes);
+                pic = courant.pic;
+            } else {
+                SuiviCourant<false> courant;
+                votes = voterBandes(courant, A.a.data(), A.w, A.h, 0, bords, rtable, 0, bords.nBandes, &scratch.groupes);
+                pic = courant.pic;
+            }
+            if (A.w > 0 && pic > 0) {
+                const size_t idx = dernierEgal(A.a.data(), A.a.size(), (uint16_t)pic);
+                suivi->peak = (uint16_t)pic;
+                suivi->px = (int)(idx % (size_t)A.w);
+                suivi->py = (int)(idx / (size_t)A.w);
+            }
+        } else {
+            SansSuivi sansSuivi;
+            votes = voterBandes(sansSuivi, A.a.data(), A.w, A.h, 0, bords, rtable, 0, bords.nBandes, &scratch.groupes);
+        }
+        if (nVotes) *nVotes += votes;
+        return;
+    }
+
+    // Tiles of consecutive bands, each voting into a private buffer that covers its rows
+    // plus the model's vertical footprint (halo). Parts saturate at 65535 on their own;
+    // min(65535, sum of parts) equals the saturating count of all votes, so the merge
+    // keeps the sequential result exactly.
+    // tiles and stats only grow: a smaller call leaves the extra ones (and their buffers) idle
+    std::vector<TamponVote::Tuile>& parts = scratch.tuiles;
+    if (parts.size() < (size_t)nTuiles) parts.resize((size_t)nTuiles);
+    const int parTuile = (bords.nBandes + nTuiles - 1) / nTuiles;
+    for (int t = 0; t < nTuiles; ++t) {
+        TamponVote::Tuile& p = parts[(size_t)t];
+        p.votes = 0;
+        p.bande0 = std::min(bords.nBandes, t * parTuile);
+        p.bande1 = std::min(bords.nBandes, (t + 1) * parTuile);
+        const int ligne0 = p.bande0 * kHauteurBandeBords;
+        const int ligne1 = std::min(A.h, p.bande1 * kHauteurBandeBords);
+        p.y0 = clampInt(ligne0 + rtable.dyMinModele, 0, A.h);
+        p.y1 = clampInt(ligne1 + rtable.dyMaxModele, 0, A.h);
+        if (p.y1 < p.y0) p.y1 = p.y0;
+    }
+
+    pool->executerParallele((size_t)nTuiles, [&](size_t t) {
+        TamponVote::Tuile& p = parts[t];
+        p.acc.clear();
+        if (p.bande0 >= p.bande1 || p.y1 <= p.y0) return;
+        p.acc.assign((size_t)(p.y1 - p.y0) * (size_t)A.w, 0);
+        SansSuivi sansSuivi;
+        p.votes = voterBandes(sansSuivi, p.acc.data(), A.w, A.h, p.y0, bords, rtable, p.bande0, p.bande1, &p.groupes);
+    });
+
+    // parallel saturating merge, by row ranges of the accumulator. Part maxima do not
+    // give the max of the sum, so peak statistics are taken here, row by row while the
+    // merged row is still in cache, in raster order within each range.
+    const int lignesParTache = (A.h + nTuiles - 1) / nTuiles;
+    std::vector<TamponVote::Stats>& stats = scratch.stats;
+    if (suivi && stats.size() < (size_t)nTuiles) stats.resize((size_t)nTuiles);
+    for (int t = 0; suivi && t < nTuiles; ++t) {
+        TamponVote::Stats& st = stats[(size_t)t];
+        st.pic = 0;
+        st.idx = 0;
+        st.auDessus.clear();
+    }
+    pool->executerParallele((size_t)nTuiles, [&](size_t t) {
+        const int r0 = (int)t * lignesParTache;
+        const int r1 = std::min(A.h, r0 + lignesParTache);
+        for (int y = r0; y < r1; ++y) {
+            uint16_t* dst = &A.a[(size_t)y * (size_t)A.w];
+            for (int k = 0; k < nTuiles; ++k) {
+                const TamponVote::Tuile& p = parts[(size_t)k];
+                if (y < p.y0 || y >= p.y1 || p.acc.empty()) continue;
+                const uint16_t* src = &p.acc[(size_t)(y - p.y0) * (size_t)A.w];
+                for (int x = 0; x < A.w; ++x) {
+                    const uint32_t v = (uint32_t)dst[x] + src[x];
+                    dst[x] = (uint16_t)(v > 65535u ? 65535u : v);
+                }
+            }
+            if (!suivi) continue;
+            TamponVote::Stats& st = stats[t];
+            const uint32_t base = (uint32_t)y * (uint32_t)A.w;
+            for (int x = 0; x < A.w; ++x) {
+                const uint16_t v = dst[x];
+                if (v >= st.pic) { st.pic = v; st.idx = base + (uint32_t)x; }
+                if (suivi->seuil && v >= suivi->seuil) st.auDessus.push_back(base + (uint32_t)x);
+            }
+        }
+    });
+
+    if (nVotes) {
+        for (int t = 0; t < nTuiles; ++t) *nVotes += parts[(size_t)t].votes;
+    }
+    if (suivi) {
+        // ranges in raster order: a later range wins ties, as in a single scan
+        uint16_t pic = 0;
+        size_t idx = A.a.size() - 1;
+        for (int t = 0; t < nTuiles; ++t) {
+            const TamponVote::Stats& st = stats[(size_t)t];
+            if ((int)t * lignesParTache >= A.h) break;
+            if (st.pic >= pic) { pic = st.pic; idx = st.idx; }
+            suivi->auDessus.insert(suivi->auDessus.end(), st.auDessus.begin(), st.auDessus.end());
+        }
+        suivi->peak = pic;
+        suivi->px = (int)(idx % (size_t)A.w);
+        suivi->py = (int)(idx / (size_t)A.w);
+    }
+}
+
+void voterVolume(
+    VolumeAccu& V,
+    const ListeBords& bords,
+    const std::vector<const RTable*>& tables,
+    uint64_t* nVotes,
+    PoolTaches* pool,
+    int tuiles,
+    uint16_t* pic,
+    TamponVote* tampon
+) {
+    TamponVote local;
+    TamponVote& scratch = tampon ? *tampon : local;
+    const int nTuiles = std::min(std::max(1, tuiles), bords.nBandes);
+    if (!pool || nTuiles <= 1) {
+        uint64_t votes = 0;
+        uint32_t max = 0;
+        for (int s = 0; s < V.n; ++s) {
+            SuiviCourant<false> courant;
+            votes += voterBandes(courant, V.plans[(size_t)s].a.data(), V.w, V.h, 0, bords, *tables[(size_t)s],
+                                 0, bords.nBandes, &scratch.groupes);
+            max = std::max(max, courant.pic);
+        }
+        if (nVotes) *nVotes += votes;
+        if (pic) *pic = (uint16_t)max;
+        return;
+    }
+
+    // same tiling as voter(), the halo covering the footprint of every scale
+    int dyMin = 0, dyMax = 0;
+    for (const RTable* rt : tables) {
+        if (rt->dx.empty()) continue;
+        dyMin = std::min(dyMin, (int)rt->dyMinModele);
+        dyMax = std::max(dyMax, (int)rt->dyMaxModele);
+    }
+    std::vector<TamponVote::Tuile>& parts = scratch.tuiles;
+    if (parts.size() < (size_t)nTuiles) parts.resize((size_t)nTuiles);
+    const int parTuile = (bords.nBandes + nTuiles - 1) / nTuiles;
+    for (int t = 0; t < nTuiles; ++t) {
+        TamponVote::Tuile& p = parts[(size_t)t];
+        p.votes = 0;
+        p.bande0 = std::min(bords.nBandes, t * parTuile);
+        p.bande1 = std::min(bords.nBandes, (t + 1) * parTuile);
+        p.y0 = clampInt(p.bande0 * kHauteurBandeBords + dyMin, 0, V.h);
+        p.y1 = clampInt(std::min(V.h, p.bande1 * kHauteurBandeBords) + dyMax, 0, V.h);
+        if (p.y1 < p.y0) p.y1 = p.y0;
+    }
+
+    // a slab holds the tile's rows of every scale, one block per scale
+    const size_t w = (size_t)V.w;
+    pool->executerParallele((size_t)nTuiles, [&](size_t t) {
+        TamponVote::Tuile& p = parts[t];
+        p.acc.clear();
+        if (p.bande0 >= p.bande1 || p.y1 <= p.y0) return;
+        const size_t bloc = (size_t)(p.y1 - p.y0) * w;
+        p.acc.assign((size_t)V.n * bloc, 0);
+        SansSuivi sansSuivi;
+        for (int s = 0; s < V.n; ++s) {
+            p.votes += voterBandes(sansSuivi, p.acc.data() + (size_t)s * bloc, V.w, V.h, p.y0, bords, *tables[(size_t)s],
+                                   p.bande0, p.bande1, &p.groupes);
+        }
+    });
+
+    // merge by row ranges: in each plane, a slab block adds onto one contiguous run of rows
+    const int lignesParTache = (V.h + nTuiles - 1) / nTuiles;
+    std::vector<TamponVote::Stats>& stats = scratch.stats;
+    if (stats.size() < (size_t)nTuiles) stats.resize((size_t)nTuiles);
+    pool->executerParallele((size_t)nTuiles, [&](size_t t) {
+        const int r0 = std::min(V.h, (int)t * lignesParTache);
+        const int r1 = std::min(V.h, r0 + lignesParTache);
+        uint16_t max = 0;
+        for (int s = 0; s < V.n; ++s) {
+            uint16_t* plan = V.plans[(size_t)s].a.data();
+            for (int k = 0; k < nTuiles; ++k) {
+                const TamponVote::Tuile& p = parts[(size_t)k];
+                const int a0 = std::max(r0, p.y0), a1 = std::min(r1, p.y1);
+                if (p.acc.empty() || a0 >= a1) continue;
+                const uint16_t* src = &p.acc[(size_t)s * (size_t)(p.y1 - p.y0) * w + (size_t)(a0 - p.y0) * w];
+                uint16_t* dst = plan + (size_t)a0 * w;
+                for (size_t i = 0, n = (size_t)(a1 - a0) * w; i < n; ++i) {
+                    const uint32_t v = (uint32_t)dst[i] + src[i];
+                    dst[i] = (uint16_t)(v > 65535u ? 65535u : v);
+                }
+            }
+            for (size_t i = (size_t)r0 * w; i < (size_t)r1 * w; ++i) max = std::max(max, plan[i]);
+        }
+        stats[t].pic = max;
+    });
+    if (nVotes) {
+        for (int t = 0; t < nTuiles; ++t) *nVotes += parts[(size_t)t].votes;
+    }
+    if (pic) {
+        *pic = 0;
+        for (int t = 0; t < nTuiles; ++t) *pic = std::max(*pic, stats[(size_t)t].pic);
+    }
+}
+
+void voter(
+    AccuImage& A,
+    const VueGradient& grads,
+    const RTable& rtable,
+    uint16_t seuilMag,
+    uint64_t* nBords,
+    uint64_t* nVotes
+) {
+    uint64_t bords = 0, votes = 0;
+
+    // vote for all pixels with sufficient gradient magnitude
+    if (grads.mag2) {
+        const uint32_t lim = seuilCarre(seuilMag);
+        const uint32_t* m2 = grads.mag2;
+        voterSi(A, grads, rtable, [&](size_t i) { return m2[i] >= lim; }, bords, votes);
+    } else {
+        const uint16_t* m = grads.mag;
+        voterSi(A, grads, rtable, [&](size_t i) { return m[i] >= seuilMag; }, bords, votes);
+    }
+    if (nBords) *nBords += bords;
+    if (nVotes) *nVotes += votes;
+}
+
+void voter(
+    AccuImage& A,
+    const grayView& img,
+    const ChampGradient& grads,
+    const RTable& rtable,
+    uint16_t seuilMag,
+    uint64_t* nBords,
+    uint64_t* nVotes
+) {
+    VueGradient v = vueGradient(grads);
+    v.w = std::min(v.w, img.w);
+    v.h = std::min(v.h, img.h);
+    voter(A, v, rtable, seuilMag, nBords, nVotes);
+}
+
+IntegralesAccu integralesAccu(const AccuImage& A) {
+    IntegralesAccu I;
+    integralesAccu(A, I);
+    return I;
+}
+
+void integralesAccu(const AccuImage& A, IntegralesAccu& I) {
+    I.w = A.w;
+    I.h = A.h;
+    const size_t w1 = (size_t)A.w + 1;
+    I.t.assign(3 * w1 * ((size_t)A.h + 1), 0);
+
+    // corner (y + 1, x + 1) = corner (y, x + 1) + prefix of row y up to x
+    for (int y = 0; y < A.h; ++y) {
+        const uint16_t* ligne = &A.a[(size_t)y * (size_t)A.w];
+        const uint64_t* haut = &I.t[3 * (size_t)y * w1];
+        uint64_t* bas = &I.t[3 * ((size_t)y + 1) * w1];
+        uint64_t s = 0, sx = 0, sy = 0;
+        for (int x = 0; x < A.w; ++x) {
+            const uint64_t v = ligne[x];
+            s += v;
+            sx += v * (uint64_t)x;
+            sy += v * (uint64_t)y;
+            const size_t c = 3 * ((size_t)x + 1);
+            bas[c]     = haut[c]     + s;
+            bas[c + 1] = haut[c + 1] + sx;
+            bas[c + 2] = haut[c + 2] + sy;
+        }
+    }
+}
+
+// Sums of A, x·A and y·A over the (2 * radius + 1)^2 window around (cx, cy), clipped to A:
+// read cell by cell, or four corners of the summed-area tables. Integer sums either way,
+// so both give the same barycenter.
+static void sommesFenetre(const AccuImage& A, const IntegralesAccu* I, int cx, int cy, int radius,
+                          uint64_t& cellules, uint64_t& sum, uint64_t& sx, uint64_t& sy) {
+    int x0 = clampInt(cx - radius, 0, A.w - 1);
+    int x1 = clampInt(cx + radius, 0, A.w - 1);
+    int y0 = clampInt(cy - radius, 0, A.h - 1);
+    int y1 = clampInt(cy + radius, 0, A.h - 1);
+
+    if (I) {
+        cellules += 4;
+        const size_t w1 = (size_t)I->w + 1;
+        const uint64_t* hg = &I->t[3 * ((size_t)y0 * w1 + (size_t)x0)];
+        const uint64_t* hd = &I->t[3 * ((size_t)y0 * w1 + (size_t)x1 + 1)];
+        const uint64_t* bg = &I->t[3 * (((size_t)y1 + 1) * w1 + (size_t)x0)];
+        const uint64_t* bd = &I->t[3 * (((size_t)y1 + 1) * w1 + (size_t)x1 + 1)];
+        sum = bd[0] - bg[0] - hd[0] + hg[0];
+        sx  = bd[1] - bg[1] - hd[1] + hg[1];
+        sy  = bd[2] - bg[2] - hd[2] + hg[2];
+        return;
+    }
+
+    cellules += (uint64_t)(x1 - x0 + 1) * (uint64_t)(y1 - y0 + 1);
+    sum = sx = sy = 0;
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            uint64_t w = A.at(y, x);
+            sum += w;
+            sx += w * (uint64_t)x;
+            sy += w * (uint64_t)y;
+        }
+    }
+}
+
+// Barycenter of the (2 * radius + 1)^2 window around the peak cell (px, py).
+static PicBary barycentreAutour(const AccuImage& A, const IntegralesAccu* I, uint16_t peak, int px, int py,
+                                int radius, uint64_t& cellules) {
+    if (peak == 0) return PicBary{false, 0, 0, 0};
+
+    uint64_t sum, sx, sy;
+    sommesFenetre(A, I, px, py, radius, cellules, sum, sx, sy);
+
+    if (sum == 0) return PicBary{false, 0, 0, peak};
+    return PicBary{true, (float)((double)sx / (double)sum), (float)((double)sy / (double)sum), peak};
+}
+
+PicBary barycentreLocalAutourMax(const AccuImage& A, int radius, uint64_t* nCellules,
+                                 const IntegralesAccu* integrales) {
+    // find max
+    uint16_t peak = 0;
+    int px = 0, py = 0;
+    for (int y = 0; y < A.h; ++y) {
+        for (int x = 0; x < A.w; ++x) {
+            uint16_t v = A.at(y, x);
+            if (v >= peak) { peak = v; px = x; py = y; }
+        }
+    }
+    uint64_t cellules = (uint64_t)A.w * (uint64_t)A.h;
+    PicBary b = barycentreAutour(A, integrales, peak, px, py, radius, cellules);
+    if (nCellules) *nCellules += cellules;
+    return b;
+}
+
+PicBary barycentreLocalAutourMax(const AccuImage& A, const SuiviPic& suivi, int radius, uint64_t* nCellules,
+                                 const IntegralesAccu* integrales) {
+    uint64_t cellules = 0;
+    PicBary b = barycentreAutour(A, integrales, suivi.peak, suivi.px, suivi.py, radius, cellules);
+    if (nCellules) *nCellules += cellules;
+    return b;
+}
+
+PicVolume picVolume(const VolumeAccu& V, int radius, int rayonEchelle, uint64_t* nCellules, const uint16_t* pic) {
+    PicVolume p;
+    if (V.n <= 0 || V.w <= 0 || V.h <= 0) return p;
+    const size_t plan = (size_t)V.w * (size_t)V.h;
+    uint64_t cellules = 0;
+    if (pic) {
+        p.peak = *pic;
+    } else {
+        for (const AccuImage& A : V.plans) {
+            for (uint16_t v : A.a) p.peak = std::max(p.peak, v);
+        }
+        cellules = plan * (size_t)V.n;
+    }
+    // raster-last pixel holding the peak over every plane, the largest scale on ties
+    size_t idx = 0;
+    bool trouve = false;
+    for (int s = 0; s < V.n; ++s) {
+        const uint16_t* a = V.plans[(size_t)s].a.data();
+        const size_t i = dernierEgal(a, plan, p.peak);
+        if (pic) cellules += plan - i;
+        if (a[i] == p.peak && (!trouve || i >= idx)) { idx = i; p.s = s; trouve = true; }
+    }
+    const int px = (int)(idx % (size_t)V.w), py = (int)(idx / (size_t)V.w);
+    if (p.peak > 0) {
+        const int x0 = clampInt(px - radius, 0, V.w - 1), x1 = clampInt(px + radius, 0, V.w - 1);
+        const int y0 = clampInt(py - radius, 0, V.h - 1), y1 = clampInt(py + radius, 0, V.h - 1);
+        const int s0 = clampInt(p.s - rayonEchelle, 0, V.n - 1), s1 = clampInt(p.s + rayonEchelle, 0, V.n - 1);
+        uint64_t sum = 0, sxy = 0, sx = 0, sy = 0, ss = 0;
+        for (int s = s0; s <= s1; ++s) {
+            const AccuImage& A = V.plans[(size_t)s];
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    const uint64_t w = A.at(y, x);
+                    sum += w;
+                    ss += w * (uint64_t)s;
+                    if (s == p.s) { sxy += w; sx += w * (uint64_t)x; sy += w * (uint64_t)y; }
+                }
+            }
+        }
+        cellules += (uint64_t)(x1 - x0 + 1) * (uint64_t)(y1 - y0 + 1) * (uint64_t)(s1 - s0 + 1);
+        if (sum > 0) {
+            p.ok = true;
+            p.bx = (float)((double)sx / (double)sxy);
+            p.by = (float)((double)sy / (double)sxy);
+            p.bs = (float)((double)ss / (double)sum);
+        }
+    }
+    if (nCellules) *nCellules += cellules;
+    return p;
+}
+
+// Greedy NMS over the candidates, in any order on entry: by value (descending, raster
+// order on ties), keep those farther than nmsRadius from every kept peak, barycenter
+// around each, stop at k. The order is total, so it can be produced in blocks:
+// nth_element pulls the next block of best candidates in O(n) and only that block is
+// sorted. On noisy accumulators the first block usually yields all k peaks and the rest
+// of the candidates is never ordered.
+static void picsGlouton(
+    const AccuImage& A,
+    std::vector<Candidat>& cands,
+    int k,
+    int nmsRadius,
+    int baryRadius,
+    const IntegralesAccu* integrales,
+    uint64_t& cellules,
+    std::vector<PicPoint>& out
+) {
+    auto avant = [](const Candidat& a, const Candidat& b) {
+        if (a.v != b.v) return a.v > b.v;
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    };
+
+    out.clear();
+    size_t debut = 0;
+    size_t bloc = std::max<size_t>(512, (size_t)std::max(k, 0) * 64);
+    while (debut < cands.size() && (int)out.size() < k) {
+        const size_t fin = std::min(cands.size(), debut + bloc);
+        const auto b0 = cands.begin() + (ptrdiff_t)debut, b1 = cands.begin() + (ptrdiff_t)fin;
+        if (fin < cands.size()) std::nth_element(b0, b1, cands.end(), avant);
+        std::sort(b0, b1, avant);
+        for (size_t i = debut; i < fin && (int)out.size() < k; ++i) {
+            const Candidat& c = cands[i];
+            bool tooClose = false;
+            for (const auto& p : out) {
+                int dx = c.x - p.x;
+                int dy = c.y - p.y;
+                if (dx*dx + dy*dy <= nmsRadius*nmsRadius) { tooClose = true; break; }
+            }
+            if (tooClose) continue;
+
+            // barycenter around (c.x,c.y)
+            uint64_t sum, sx, sy;
+            sommesFenetre(A, integrales, c.x, c.y, baryRadius, cellules, sum, sx, sy);
+
+            PicPoint pp;
+            pp.x = c.x; pp.y = c.y; pp.v = c.v;
+            if (sum > 0) { pp.bx = (float)((double)sx / (double)sum); pp.by = (float)((double)sy / (double)sum); }
+            else { pp.bx = (float)c.x; pp.by = (float)c.y; }
+            out.push_back(pp);
+        }
+        debut = fin;
+        bloc *= 4;
+    }
+}
+
+std::vector<PicPoint> topKpicsAvecBary(
+    const AccuImage& A,
+    int k,
+    int nmsRadius,
+    int baryRadius,
+    uint16_t minVal,
+    uint64_t* nCellules,
+    const IntegralesAccu* integrales
+) {
+    // all candidates above minVal, then greedy NMS with barycenters
+    std::vector<Candidat> cands;
+    cands.reserve(2048);
+
+    for (int y = 0; y < A.h; ++y) {
+        for (int x = 0; x < A.w; ++x) {
+            uint16_t v = A.at(y, x);
+            if (v >= minVal) cands.push_back({x,y,v});
+        }
+    }
+    uint64_t cellules = (uint64_t)A.w * (uint64_t)A.h;
+    std::vector<PicPoint> out;
+    picsGlouton(A, cands, k, nmsRadius, baryRadius, integrales, cellules, out);
+    if (nCellules) *nCellules += cellules;
+    return out;
+}
+
+std::vector<PicPoint> topKpicsAvecBary(
+    const AccuImage& A,
+    const SuiviPic& suivi,
+    int k,
+    int nmsRadius,
+    int baryRadius,
+    uint64_t* nCellules,
+    const IntegralesAccu* integrales
+) {
+    std::vector<PicPoint> out;
+    std::vector<Candidat> cands;
+    topKpicsAvecBary(A, suivi, k, nmsRadius, baryRadius, out, cands, nCellules, integrales);
+    return out;
+}
+
+void topKpicsAvecBary(
+    const AccuImage& A,
+    const SuiviPic& suivi,
+    int k,
+    int nmsRadius,
+    int baryRadius,
+    std::vector<PicPoint>& out,
+    std::vector<Candidat>& cands,
+    uint64_t* nCellules,
+    const IntegralesAccu* integrales
+) {
+    if (suivi.seuil == 0) {
+        out = topKpicsAvecBary(A, k, nmsRadius, baryRadius, 0, nCellules, integrales);
+        return;
+    }
+
+    // the crossing list holds exactly the cells >= minVal (the order is picsGlouton's)
+    cands.clear();
+    for (uint32_t i : suivi.auDessus) {
+        cands.push_back({(int)(i % (uint32_t)A.w), (int)(i / (uint32_t)A.w), A.a[i]});
+    }
+    uint64_t cellules = cands.size();
+    picsGlouton(A, cands, k, nmsRadius, baryRadius, integrales, cellules, out);
+    if (nCellules) *nCellules += cellules;
+}
+
+// pair selection
+bool choisirPaireYeux(
+    const std::vector<PicPoint>& pics,
+    int faceCxInZone,
+    int faceCyInZone,
+    int minDx, int maxDx,
+    int maxDy,
+    PicPoint& oeilGauche,
+    PicPoint& oeilDroit
+) {
+    bool found = false;
+    uint32_t best = 0;
+
+    for (size_t i = 0; i < pics.size(); ++i) {
+        for (size_t j = i + 1; j < pics.size(); ++j) {
+            const auto& p1 = pics[i];
+            const auto& p2 = pics[j];
+
+            // order left-right
+            const auto& L = (p1.bx <= p2.bx) ? p1 : p2;
+            const auto& R = (p1.bx <= p2.bx) ? p2 : p1;
+
+            int dx = (int)std::lround(R.bx - L.bx);
+            int dy = (int)std::lround(std::fabs(R.by - L.by));
+
+            if (dx < minDx || dx > maxDx) continue;
+            if (dy > maxDy) continue;
+
+            // keep roughly above face center
+            if ((int)std::lround(L.by) > faceCyInZone) continue;
+            if ((int)std::lround(R.by) > faceCyInZone) continue;
+
+            uint32_t score = (uint32_t)L.v + (uint32_t)R.v;
+            if (!found || score > best) {
+                found = true;
+                best = score;
+                oeilGauche = L;
+                oeilDroit = R;
+            }
+        }
+    }
+    return found;
+}
+
+// -------------------- templates --------------------
+static grayImage templateEllipse(int w, int h, float rx, float ry) {
+    grayImage img = makeGris(w, h, 255);
+    int cx = w / 2;
+    int cy = h / 2;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            float dx = (float)(x - cx);
+            float dy = (float)(y - cy);
+            float v = (dx*dx)/(rx*rx) + (dy*dy)/(ry*ry);
+            if (std::fabs(v - 1.0f) < 0.03f) img.at(y, x) = 0;
+        }
+    }
+    return img;
+}
+
+static grayImage templateCercle(int w, int h, float r) {
+    grayImage img = makeGris(w, h, 255);
+    int cx = w / 2;
+    int cy = h / 2;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            float dx = (float)(x - cx);
+            float dy = (float)(y - cy);
+            float d = std::sqrt(dx*dx + dy*dy);
+            if (std::fabs(d - r) < 2.5f) img.at(y, x) = 0;
+        }
+    }
+    return img;
+}
+
+RTable construireRTableDepuisTemplate(const grayImage& templ, uint16_t minMag, uint16_t maxMag) {
+    ChampGradient g = sobel(vue(templ));
+
+    // template center
+    int cx = templ.w / 2;
+    int cy = templ.h / 2;
+
+    ListesRTable bins;
+
+    for (int y = 0; y < templ.h; ++y) {
+        for (int x = 0; x < templ.w; ++x) {
+            uint16_t mag = g.m(y, x);
+            if (mag < minMag || mag > maxMag) continue;
+            uint16_t ang = g.a(y, x);
+
+            int dx = cx - x;
+            int dy = cy - y;
+            bins[(size_t)ang].push_back({(int16_t)dx, (int16_t)dy});
+        }
+    }
+    return rtableDepuisListes(bins);
+}
+
+RTable reduireRTable(const RTable& rt, int facteur) {
+    auto reduire = [facteur](int16_t d) {
+        return (int16_t)std::lround((double)d / (double)facteur);
+    };
+    ListesRTable bins;
+    for (size_t b = 0; b < 360; ++b) {
+        auto& liste = bins[b];
+        for (uint32_t k = rt.debut[b]; k < rt.debut[b + 1]; ++k) {
+            liste.push_back({reduire(rt.dx[k]), reduire(rt.dy[k])});
+        }
+        std::sort(liste.begin(), liste.end());
+        liste.erase(std::unique(liste.begin(), liste.end()), liste.end());
+    }
+    return rtableDepuisListes(bins);
+}
+
+RTable rtableCercle(float r) {
+    static const double kRadParDegre = 3.14159265358979323846 / 180.0;
+    ListesRTable bins;
+    for (size_t b = 0; b < 360; ++b) {
+        const double t = (double)b * kRadParDegre;
+        bins[b].push_back({(int16_t)std::lround(-r * std::cos(t)), (int16_t)std::lround(-r * std::sin(t))});
+    }
+    return rtableDepuisListes(bins);
+}
+
+RTable rtableEllipse(float rx, float ry) {
+    static const double kRadParDegre = 3.14159265358979323846 / 180.0;
+    ListesRTable bins;
+    for (size_t b = 0; b < 360; ++b) {
+        const double t = (double)b * kRadParDegre;
+        const double phi = std::atan2((double)ry * std::sin(t), (double)rx * std::cos(t));
+        const int16_t dx = (int16_t)std::lround(rx * std::cos(phi));
+        const int16_t dy = (int16_t)std::lround(ry * std::sin(phi));
+        bins[b].push_back({(int16_t)-dx, (int16_t)-dy});
+        bins[b].push_back({dx, dy});
+    }
+    return rtableDepuisListes(bins);
+}
+
+// -------------------- adaptive threshold helper --------------------
+uint16_t magPercentile(const ChampGradient& cg, double q /*0..1*/) {
+    // sample to reduce cost
+    std::vector<uint32_t> s;
+    s.reserve((size_t)(cg.w * cg.h / 4));
+    return magPercentile(cg, q, s);
+}
+
+uint16_t magPercentile(const ChampGradient& cg, double q, std::vector<uint32_t>& s) {
+    // lround(sqrt(.)) is monotone: the percentile of squares maps onto the magnitude percentile
+    s.clear();
+    for (int y = 0; y < cg.h; y += 2) {
+        for (int x = 0; x < cg.w; x += 2) {
+            const size_t i = (size_t)y * (size_t)cg.w + (size_t)x;
+            s.push_back(cg.carre() ? cg.mag2[i] : (uint32_t)cg.mag[i]);
+        }
+    }
+    if (s.empty()) return 0;
+
+    size_t idx = (size_t)std::lround(q * (double)(s.size() - 1));
+    idx = std::min(idx, s.size() - 1);
+
+    std::nth_element(s.begin(), s.begin() + idx, s.end());
+    if (!cg.carre()) return (uint16_t)s[idx];
+    return (uint16_t)clampInt((int)std::lround(std::sqrt((float)s[idx])), 0, 65535);
+}
+
+faceeyes detectfaceeyes(
+    const grayView& img,
+    const std::vector<facemodel>& faceModels,
+    const std::vector<eyemodel>& eyeModels,
+    uint16_t seuilFace, uint16_t seuilEye,
+    uint16_t faceMinScore, uint16_t eyeMinPeak,
+    const OptionsMoteur& moteur,
+    MesuresDetection* mesures
+) {
+    Horloge::time_point t0 = Horloge::now();
+    ChampGradient grads = moteur.gradientRapide ? sobelRapide(img, std::min(seuilFace, seuilEye)) : sobel(img);
+    noterEtape(mesures, "sobel", "frame", -1, t0);
+    return detectfaceeyesGradient(img, std::move(grads), faceModels, eyeModels,
+                                  seuilFace, seuilEye, faceMinScore, eyeMinPeak, moteur, mesures);
+}
+
+// Band tiles for one voter() call: explicit count, or in auto mode one per pool thread
+// once the edge list is large enough to amortize the private accumulators and merge.
+static int tuilesVote(const OptionsMoteur& moteur, const ListeBords& bords) {
+    if (!moteur.pool) return 1;
+    if (moteur.tuilesVote > 0) return moteur.tuilesVote;
+    static const size_t kBordsMinTuiles = 50000;
+    return bords.taille() >= kBordsMinTuiles ? moteur.pool->taille() + 1 : 1;
+}
+
+// -------------------- coarse-to-fine (OptionsMoteur::pyramide) --------------------
+static const int kRayonBaryFace = 6;
+static const int kDemiFenetrePyramide = 4;   // reduced cells around a coarse max, refined at full size
+static const int kDeplacementsPyramide = 4;  // window moves following the max, per scale
+static const float kRapportPyramide = 0.4f;  // decisive: nothing else on the coarse frame reaches rapport x best
+
+// Reduced table of a model for facteur 2 or 4, from the bank or derived into tmp.
+static const RTable& lutReduite(const RTable& lut, const std::array<RTable, 2>& reduites, int facteur, RTable& tmp) {
+    const RTable& r = reduites[facteur == 4 ? 1 : 0];
+    if (!r.dx.empty() || lut.dx.empty()) return r;
+    tmp = reduireRTable(lut, facteur);
+    return tmp;
+}
+
+// Face table of a model for the engine in use, at full resolution (facteur 1) or reduced.
+static const RTable& lutFace(const facemodel& fm, const OptionsMoteur& moteur, int facteur, RTable& tmp) {
+    if (!moteur.visageEllipse) return facteur > 1 ? lutReduite(fm.lut, fm.reduites, facteur, tmp) : fm.lut;
+    if (facteur == 1 && !fm.ellipse.dx.empty()) return fm.ellipse;
+    const RTable& r = fm.ellipsesReduites[facteur == 4 ? 1 : 0];
+    if (facteur > 1 && !r.dx.empty()) return r;
+    tmp = rtableEllipse((float)fm.rx / (float)facteur, (float)fm.ry / (float)facteur);
+    return tmp;
+}
+
+// Eye table of a model for the engine in use, at full resolution (facteur 1) or reduced.
+static const RTable& lutOeil(const eyemodel& em, const OptionsMoteur& moteur, int facteur, RTable& tmp) {
+    if (!moteur.yeuxCercle) return facteur > 1 ? lutReduite(em.lut, em.reduites, facteur, tmp) : em.lut;
+    if (facteur == 1 && !em.cercle.dx.empty()) return em.cercle;
+    const RTable& r = em.cerclesReduits[facteur == 4 ? 1 : 0];
+    if (facteur > 1 && !r.dx.empty()) return r;
+    tmp = rtableCercle((float)em.r / (float)facteur);
+    return tmp;
+}
+
+// 1 when the pyramid is off or the frame too small to reduce.
+static int facteurPyramide(const OptionsMoteur& moteur, const grayView& img) {
+    const int f = moteur.pyramide == 2 || moteur.pyramide == 4 ? moteur.pyramide : 1;
+    return img.w >= 8 * f && img.h >= 8 * f ? f : 1;
+}
+
+// Edges of a reduced image (ws.reduite into ws.bordsReduits): only the list is used, so
+// the fast field (angles above the vote threshold only, same bins as sobel()) whatever the
+// full-resolution engine.
+static void bordsReduits(EspaceTravail& ws, uint16_t seuil) {
+    sobelRapide(vue(ws.reduite), ws.gradsReduits, ws.lignesSobel, seuil);
+    extraireBords(vueGradient(ws.gradsReduits), seuil, ws.bordsReduits, ws.brut);
+}
+
+// Max of A outside the square of half-side demi around (x, y).
+static uint16_t maxHorsFenetre(const AccuImage& A, int x, int y, int demi) {
+    uint16_t m = 0;
+    for (int yy = 0; yy < A.h; ++yy) {
+        const uint16_t* ligne = &A.a[(size_t)yy * (size_t)A.w];
+        if (std::abs(yy - y) > demi) {
+            for (int xx = 0; xx < A.w; ++xx) m = std::max(m, ligne[xx]);
+            continue;
+        }
+        for (int xx = 0; xx < std::min(A.w, x - demi); ++xx) m = std::max(m, ligne[xx]);
+        for (int xx = std::max(0, x + demi + 1); xx < A.w; ++xx) m = std::max(m, ligne[xx]);
+    }
+    return m;
+}
+
+// Winner of the face stage: model index (-1 = none), barycentered peak in frame
+// coordinates, and its accumulator (workspace storage), which covers the frame from (x0, y0).
+struct ChoixFace {
+    int modele = -1;
+    PicBary b;
+    AccuImage* A = nullptr;
+    int x0 = 0, y0 = 0;  // frame position of A (pyramid windows)
+    float echelle = -1.0f;  // fractional scale index (volume), -1 = modele's own size
+};
+
+// Face stage at full resolution: the models chosen by voterEchelles() on the whole frame
+// (concurrently on the engine pool), then the best peak (barycentered max) in model order
+// so the winner does not depend on scheduling.
+static ChoixFace faceComplete(const grayView& img, const ChampGradient& grads, const std::vector<facemodel>& faceModels,
+                              uint16_t seuilFace, const OptionsMoteur& moteur, MesuresDetection* mesures,
+                              EspaceTravail& ws) {
+    Horloge::time_point t0 = Horloge::now();
+    extraireBords(vueGradient(grads), seuilFace, ws.bordsFace, ws.brut);
+    const ListeBords& bordsFace = ws.bordsFace;
+    noterEtape(mesures, "bords", "face", -1, t0);
+
+    ws.faces.resize(faceModels.size());
+    voterEchelles(moteur, faceModels.size(), ws.vote, ws.lot, [&](size_t mi) {
+        EspaceTravail::Modele& v = ws.faces[mi];
+        v.m.etapes.clear();
+        MesuresDetection* m = mesures ? &v.m : nullptr;
+        preparerAccu(v.A, img.w, img.h);
+        uint64_t votes = 0, cellules = 0;
+        v.suivi.seuil = 0;
+        RTable tmp;
+        const RTable& lut = lutFace(faceModels[mi], moteur, 1, tmp);
+        Horloge::time_point t = Horloge::now();
+        voter(v.A, bordsFace, lut, &votes, moteur.pool, tuilesVote(moteur, bordsFace), &v.suivi, &v.tampon);
+        noterEtape(m, "voter", "face", (int)mi, t, bordsFace.taille(), votes);
+
+        if (moteur.baryIntegrale) {
+            t = Horloge::now();
+            integralesAccu(v.A, v.integrales);
+            noterEtape(m, "integrales", "face", (int)mi, t, 0, 0, (uint64_t)v.A.w * (uint64_t)v.A.h);
+        }
+        t = Horloge::now();
+        v.b = barycentreLocalAutourMax(v.A, v.suivi, kRayonBaryFace, &cellules, moteur.baryIntegrale ? &v.integrales : nullptr);
+        noterEtape(m, "barycentre", "face", (int)mi, t, 0, 0, cellules);
+    }, [&](size_t mi) { return ws.faces[mi].b.ok ? ws.faces[mi].b.peak : (uint16_t)0; });
+
+    ChoixFace choix;
+    uint16_t pic = 0;
+    for (size_t mi = 0; mi < faceModels.size(); ++mi) {
+        if (!ws.vote[mi]) continue;
+        if (mesures) fusionnerMesures(*mesures, ws.faces[mi].m);
+        if (ws.faces[mi].b.ok && ws.faces[mi].b.peak >= pic) {
+            pic = ws.faces[mi].b.peak;
+            choix.modele = (int)mi;
+        }
+    }
+    if (choix.modele >= 0) {
+        choix.b = ws.faces[(size_t)choix.modele].b;
+        choix.A = &ws.faces[(size_t)choix.modele].A;
+    }
+    return choix;
+}
+
+// Face stage on one (x, y, scale) volume: every model voted into its scale, then the joint
+// peak; A is the winning scale's plane, in the volume itself.
+static ChoixFace faceVolume(const grayView& img, const ChampGradient& grads, const std::vector<facemodel>& faceModels,
+                            uint16_t seuilFace, const OptionsMoteur& moteur, MesuresDetection* mesures,
+                            EspaceTravail& ws) {
+    ChoixFace choix;
+    if (faceModels.empty()) return choix;
+    Horloge::time_point t = Horloge::now();
+    extraireBords(vueGradient(grads), seuilFace, ws.bordsFace, ws.brut);
+    const ListeBords& bords = ws.bordsFace;
+    noterEtape(mesures, "bords", "face", -1, t);
+
+    ws.tmpVolume.resize(faceModels.size());
+    ws.tablesVolume.resize(faceModels.size());
+    for (size_t mi = 0; mi < faceModels.size(); ++mi) {
+        ws.tablesVolume[mi] = &lutFace(faceModels[mi], moteur, 1, ws.tmpVolume[mi]);
+    }
+
+    VolumeAccu& V = ws.volume;
+    preparerVolume(V, img.w, img.h, (int)faceModels.size());
+    t = Horloge::now();
+    uint64_t votes = 0, cellules = 0;
+    uint16_t pic = 0;
+    voterVolume(V, bords, ws.tablesVolume, &votes, moteur.pool, tuilesVote(moteur, bords), &pic, &ws.tamponVolume);
+    noterEtape(mesures, "voter", "face_volume", -1, t, bords.taille(), votes);
+
+    t = Horloge::now();
+    const PicVolume p = picVolume(V, kRayonBaryFace, 1, &cellules, &pic);
+    noterEtape(mesures, "barycentre", "face_volume", -1, t, 0, 0, cellules);
+    if (!p.ok) return choix;
+    choix.modele = p.s;
+    choix.b = PicBary{true, p.bx, p.by, p.peak};
+    choix.echelle = p.bs;
+    choix.A = &V.plans[(size_t)p.s];
+    return choix;
+}
+
+// Full-resolution vote of one face model restricted to the window (x0..x1, y0..y1).
+// Edge pixels come from the region whose footprint reaches the window and its barycentre
+// margin, so the window cells hold exactly their full-frame counts; the peak is the
+// raster-last max of the window, as a frame scan would find it there.
+static void affinerFace(EspaceTravail::Fenetre& f, const ChampGradient& grads, const RTable& lut, uint16_t seuilFace,
+                        int x0, int x1, int y0, int y1, const OptionsMoteur& moteur, MesuresDetection* m, int mi) {
+    const int bx0 = clampInt(x0 - kRayonBaryFace, 0, grads.w - 1), bx1 = clampInt(x1 + kRayonBaryFace, 0, grads.w - 1);
+    const int by0 = clampInt(y0 - kRayonBaryFace, 0, grads.h - 1), by1 = clampInt(y1 + kRayonBaryFace, 0, grads.h - 1);
+    const int rx0 = clampInt(bx0 - lut.dxMaxModele, 0, grads.w - 1), rx1 = clampInt(bx1 - lut.dxMinModele, 0, grads.w - 1);
+    const int ry0 = clampInt(by0 - lut.dyMaxModele, 0, grads.h - 1), ry1 = clampInt(by1 - lut.dyMinModele, 0, grads.h - 1);
+
+    Horloge::time_point t = Horloge::now();
+    extraireBords(sousVueGradient(grads, rx0, ry0, rx1 - rx0 + 1, ry1 - ry0 + 1), seuilFace, f.bords, f.brut);
+    preparerAccu(f.A, f.bords.w, f.bords.h);
+    f.x0 = rx0;
+    f.y0 = ry0;
+    uint64_t votes = 0, cellules = 0;
+    voter(f.A, f.bords, lut, &votes, moteur.pool, tuilesVote(moteur, f.bords), nullptr, &f.tampon);
+    noterEtape(m, "voter", "face", mi, t, f.bords.taille(), votes);
+
+    t = Horloge::now();
+    SuiviPic suivi;
+    for (int y = y0 - ry0; y <= y1 - ry0; ++y) {
+        for (int x = x0 - rx0; x <= x1 - rx0; ++x) {
+            const uint16_t v = f.A.at(y, x);
+            if (v >= suivi.peak) { suivi.peak = v; suivi.px = x; suivi.py = y; }
+        }
+    }
+    cellules += (uint64_t)(x1 - x0 + 1) * (uint64_t)(y1 - y0 + 1);
+    f.px = suivi.px + rx0;
+    f.py = suivi.py + ry0;
+    f.b = barycentreLocalAutourMax(f.A, suivi, kRayonBaryFace, &cellules);
+    f.b.bx += (float)rx0;
+    f.b.by += (float)ry0;
+    noterEtape(m, "barycentre", "face", mi, t, 0, 0, cellules);
+}
+
+// Face stage of the pyramid. The scales chosen by voterEchelles() are voted on the reduced
+// frame. The coarse frame is decisive when no scale reaches kRapportPyramide of the best
+// coarse peak outside kDemiFenetrePyramide cells of its own max. Then the best scale, its
+// neighbours and every scale reaching that ratio are voted at full resolution in a window
+// covering those cells around their coarse max; a window whose max lies on its border (not
+// the frame's) moves onto that max, up to kDeplacementsPyramide times, and the best refined
+// peak wins. Otherwise (no coarse peak either) faceComplete() decides: refining the coarse
+// frame's guesses would land elsewhere than the full search.
+static ChoixFace facePyramide(const grayView& img, const ChampGradient& grads, const std::vector<facemodel>& faceModels,
+                              uint16_t seuilFace, int facteur, const OptionsMoteur& moteur,
+                              MesuresDetection* mesures, EspaceTravail& ws) {
+    Horloge::time_point t0 = Horloge::now();
+    reduireImage(img, facteur, ws.reduite);
+    noterEtape(mesures, "reduire", "frame", -1, t0);
+    t0 = Horloge::now();
+    bordsReduits(ws, seuilFace);
+    const ListeBords& bords = ws.bordsReduits;
+    noterEtape(mesures, "bords", "face_grossier", -1, t0);
+
+    const int rayonBary = (kRayonBaryFace + facteur - 1) / facteur;
+    ws.faces.resize(faceModels.size());
+    voterEchelles(moteur, faceModels.size(), ws.vote, ws.lot, [&](size_t mi) {
+        EspaceTravail::Modele& v = ws.faces[mi];
+        v.m.etapes.clear();
+        MesuresDetection* m = mesures ? &v.m : nullptr;
+        RTable tmp;
+        const RTable& lut = lutFace(faceModels[mi], moteur, facteur, tmp);
+        preparerAccu(v.A, ws.reduite.w, ws.reduite.h);
+        uint64_t votes = 0, cellules = 0;
+        v.suivi.seuil = 0;
+        Horloge::time_point t = Horloge::now();
+        voter(v.A, bords, lut, &votes, moteur.pool, tuilesVote(moteur, bords), &v.suivi, &v.tampon);
+        noterEtape(m, "voter", "face_grossier", (int)mi, t, bords.taille(), votes);
+        t = Horloge::now();
+        v.b = barycentreLocalAutourMax(v.A, v.suivi, rayonBary, &cellules);
+        noterEtape(m, "barycentre", "face_grossier", (int)mi, t, 0, 0, cellules);
+    }, [&](size_t mi) { return ws.faces[mi].b.ok ? ws.faces[mi].b.peak : (uint16_t)0; });
+
+    // best coarse peak (later model on ties, as the full search)
+    const int nModeles = (int)faceModels.size();
+    int mc = -1;
+    uint16_t pic = 0;
+    for (int mi = 0; mi < nModeles; ++mi) {
+        if (!ws.vote[(size_t)mi]) continue;
+        if (mesures) fusionnerMesures(*mesures, ws.faces[(size_t)mi].m);
+        if (ws.faces[(size_t)mi].b.ok && ws.faces[(size_t)mi].b.peak >= pic) {
+            pic = ws.faces[(size_t)mi].b.peak;
+            mc = mi;
+        }
+    }
+
+    // refined: mc, its neighbours and every scale whose coarse peak reaches the ratio; the
+    // coarse frame decides unless some scale also reaches it away from its own max
+    t0 = Horloge::now();
+    ws.lot.clear();
+    bool decisif = mc >= 0;
+    uint64_t cellules = 0;
+    const float seuilAutre = kRapportPyramide * (float)pic;
+    for (int mi = 0; decisif && mi < nModeles; ++mi) {
+        const EspaceTravail::Modele& v = ws.faces[(size_t)mi];
+        if (!ws.vote[(size_t)mi] || !v.b.ok) continue;
+        if (std::abs(mi - mc) > 1 && (float)v.suivi.peak < seuilAutre) continue;
+        decisif = (float)maxHorsFenetre(v.A, v.suivi.px, v.suivi.py, kDemiFenetrePyramide) < seuilAutre;
+        cellules += v.A.a.size();
+        ws.lot.push_back((size_t)mi);
+    }
+    noterEtape(mesures, "marge", "face_grossier", -1, t0, 0, 0, cellules);
+    if (!decisif) {
+        noterEtape(mesures, "repli", "face", -1, Horloge::now());
+        return faceComplete(img, grads, faceModels, seuilFace, moteur, mesures, ws);
+    }
+
+    // the first window covers the reduced cells spared by the check around the coarse max,
+    // and one more (reduced cell X covers full-size pixels facteur * X .. facteur * X + facteur - 1)
+    const int demi = (kDemiFenetrePyramide + 1) * facteur;
+    if (ws.fenetres.size() < ws.lot.size()) ws.fenetres.resize(ws.lot.size());
+    pourChaqueModele(moteur, ws.lot.size(), [&](size_t i) {
+        EspaceTravail::Fenetre& f = ws.fenetres[i];
+        f.m.etapes.clear();
+        f.modele = (int)ws.lot[i];
+        const SuiviPic& s = ws.faces[ws.lot[i]].suivi;
+        RTable tmp;
+        const RTable& lut = lutFace(faceModels[(size_t)f.modele], moteur, 1, tmp);
+        int x = s.px * facteur + facteur / 2, y = s.py * facteur + facteur / 2;
+        for (int d = 0;; ++d) {
+            const int x0 = clampInt(x - demi, 0, img.w - 1), x1 = clampInt(x + demi, 0, img.w - 1);
+            const int y0 = clampInt(y - demi, 0, img.h - 1), y1 = clampInt(y + demi, 0, img.h - 1);
+            affinerFace(f, grads, lut, seuilFace, x0, x1, y0, y1, moteur, mesures ? &f.m : nullptr, f.modele);
+            const bool bord = (f.px == x0 && x0 > 0) || (f.px == x1 && x1 < img.w - 1) ||
+                              (f.py == y0 && y0 > 0) || (f.py == y1 && y1 < img.h - 1);
+            if (!f.b.ok || !bord || d == kDeplacementsPyramide) break;
+            x = f.px;
+            y = f.py;
+        }
+    });
+
+    // best refined peak, ties to the later model as in faceComplete() (ws.lot ascends)
+    ChoixFace choix;
+    int gagnant = -1;
+    uint16_t picFin = 0;
+    for (size_t i = 0; i < ws.lot.size(); ++i) {
+        const EspaceTravail::Fenetre& f = ws.fenetres[i];
+        if (mesures) fusionnerMesures(*mesures, f.m);
+        if (f.b.ok && f.b.peak >= picFin) {
+            picFin = f.b.peak;
+            gagnant = (int)i;
+        }
+    }
+    if (gagnant < 0) return choix;
+    EspaceTravail::Fenetre& f = ws.fenetres[(size_t)gagnant];
+    choix.modele = f.modele;
+    choix.b = f.b;
+    choix.A = &f.A;
+    choix.x0 = f.x0;
+    choix.y0 = f.y0;
+    return choix;
+}
+
+// Eye models voted for a face of half-width rx (OptionsMoteur::ratioRayonOeilMin/Max):
+// every radius, or those inside the band; when the band falls between two radii, the
+// closest one.
+static void rayonsPourVisage(const std::vector<eyemodel>& eyeModels, int rx, const OptionsMoteur& moteur,
+                             std::vector<size_t>& rayons) {
+    rayons.clear();
+    const bool bande = moteur.ratioRayonOeilMax > 0.0f;
+    const float rMin = moteur.ratioRayonOeilMin * (float)rx, rMax = moteur.ratioRayonOeilMax * (float)rx;
+    for (size_t mi = 0; mi < eyeModels.size(); ++mi) {
+        const float r = (float)eyeModels[mi].r;
+        if (!bande || (r >= rMin && r <= rMax)) rayons.push_back(mi);
+    }
+    if (rayons.empty() && !eyeModels.empty()) {
+        const float centre = 0.5f * (rMin + rMax);
+        size_t proche = 0;
+        for (size_t mi = 1; mi < eyeModels.size(); ++mi) {
+            if (std::fabs((float)eyeModels[mi].r - centre) < std::fabs((float)eyeModels[proche].r - centre)) proche = mi;
+        }
+        rayons.push_back(proche);
+    }
+}
+
+// Eye radii of the pyramid: the candidates (ws.rayons, narrowed in place) are voted on the
+// ROI reduced by 2 into the eye accumulators. When the best coarse peak is decisive (the
+// candidates beyond its neighbours all stay below kRapportPyramide of it), only it and its
+// neighbours are voted at full resolution; otherwise every candidate is.
+static void yeuxPyramide(const grayView& zoneYeux, const std::vector<eyemodel>& eyeModels, uint16_t seuilEye,
+                         const OptionsMoteur& moteur, MesuresDetection* mesures, EspaceTravail& ws) {
+    static const int kFacteurYeux = 2;
+    std::vector<size_t>& candidats = ws.rayons;
+    if (candidats.size() <= 3 || zoneYeux.w < 4 * kFacteurYeux || zoneYeux.h < 4 * kFacteurYeux) return;
+
+    Horloge::time_point t0 = Horloge::now();
+    reduireImage(zoneYeux, kFacteurYeux, ws.reduite);
+    bordsReduits(ws, seuilEye);
+    const ListeBords& bords = ws.bordsReduits;
+    noterEtape(mesures, "bords", "yeux_grossier", -1, t0);
+
+    if (ws.yeux.size() < candidats.size()) ws.yeux.resize(candidats.size());
+    pourChaqueModele(moteur, candidats.size(), [&](size_t i) {
+        const size_t mi = candidats[i];
+        EspaceTravail::Modele& v = ws.yeux[i];
+        v.m.etapes.clear();
+        MesuresDetection* m = mesures ? &v.m : nullptr;
+        RTable tmp;
+        const RTable& lut = lutOeil(eyeModels[mi], moteur, kFacteurYeux, tmp);
+        preparerAccu(v.A, ws.reduite.w, ws.reduite.h);
+        uint64_t votes = 0;
+        v.suivi.seuil = 0;
+        Horloge::time_point t = Horloge::now();
+        voter(v.A, bords, lut, &votes, moteur.pool, tuilesVote(moteur, bords), &v.suivi, &v.tampon);
+        noterEtape(m, "voter", "yeux_grossier", (int)mi, t, bords.taille(), votes);
+    });
+
+    int meilleur = -1;
+    uint16_t pic = 0;
+    for (size_t i = 0; i < candidats.size(); ++i) {
+        if (mesures) fusionnerMesures(*mesures, ws.yeux[i].m);
+        if (ws.yeux[i].suivi.peak > 0 && ws.yeux[i].suivi.peak >= pic) { pic = ws.yeux[i].suivi.peak; meilleur = (int)i; }
+    }
+    if (meilleur < 0) return;
+    for (size_t i = 0; i < candidats.size(); ++i) {
+        if (std::abs((int)i - meilleur) > 1 && (float)ws.yeux[i].suivi.peak >= kRapportPyramide * (float)pic) {
+            noterEtape(mesures, "repli", "yeux", -1, Horloge::now());
+            return;
+        }
+    }
+
+    const size_t debut = (size_t)std::max(0, meilleur - 1);
+    const size_t fin = std::min(candidats.size(), (size_t)meilleur + 2);
+    candidats.erase(candidats.begin() + (ptrdiff_t)fin, candidats.end());
+    candidats.erase(candidats.begin(), candidats.begin() + (ptrdiff_t)debut);
+}
+
+faceeyes detectfaceeyesGradient(
+    const grayView& img,
+    EspaceTravail& ws,
+    const std::vector<facemodel>& faceModels,
+    const std::vector<eyemodel>& eyeModels,
+    uint16_t seuilFace, uint16_t seuilEye,
+    uint16_t faceMinScore, uint16_t eyeMinPeak,
+    const OptionsMoteur& moteur,
+    MesuresDetection* mesures
+) {
+    faceeyes out;
+    const ChampGradient& grads = ws.grads;
+    ws.accuFace = ws.accuYeux = nullptr;
+    ws.accuFaceX0 = ws.accuFaceY0 = 0;
+    if (!tailleImageValide(img.w, img.h)) return out;
+
+    const int facteur = facteurPyramide(moteur, img);
+    ChoixFace face = facteur > 1
+        ? facePyramide(img, grads, faceModels, seuilFace, facteur, moteur, mesures, ws)
+        : moteur.volumeFace
+        ? faceVolume(img, grads, faceModels, seuilFace, moteur, mesures, ws)
+        : faceComplete(img, grads, faceModels, seuilFace, moteur, mesures, ws);
+
+    uint16_t bestFacePeak = 0;
+    int bestFaceX = 0, bestFaceY = 0;
+    int bestRx = 0, bestRy = 0;
+    if (face.modele >= 0) {
+        bestFacePeak = face.b.peak;
+        bestFaceX = (int)std::lround(face.b.bx);
+        bestFaceY = (int)std::lround(face.b.by);
+        bestRx = faceModels[(size_t)face.modele].rx;
+        bestRy = faceModels[(size_t)face.modele].ry;
+        if (face.echelle >= 0.0f) {
+            // size between the two scales around the fractional index
+            const size_t s0 = std::min((size_t)face.echelle, faceModels.size() - 1);
+            const size_t s1 = std::min(s0 + 1, faceModels.size() - 1);
+            const float f = face.echelle - (float)s0;
+            bestRx = (int)std::lround((1.0f - f) * (float)faceModels[s0].rx + f * (float)faceModels[s1].rx);
+            bestRy = (int)std::lround((1.0f - f) * (float)faceModels[s0].ry + f * (float)faceModels[s1].ry);
+        }
+    }
+
+    ws.accuFace = face.A;
+    ws.accuFaceX0 = face.x0;
+    ws.accuFaceY0 = face.y0;
+
+    if (bestFacePeak < faceMinScore) {
+        out.faceOk = false;
+        return out;
+    }
+
+    out.faceOk = true;
+    out.faceX = bestFaceX;
+    out.faceY = bestFaceY;
+    out.faceRx = bestRx;
+    out.faceRy = bestRy;
+
+    // EYES: ROI above face center (tighten to reduce window edges)
+    int zx0 = clampInt(bestFaceX - (int)std::lround(bestRx * 1.2), 0, img.w - 1);
+    int zx1 = clampInt(bestFaceX + (int)std::lround(bestRx * 1.2), 0, img.w - 1);
+    int zy0 = clampInt(bestFaceY - (int)std::lround(bestRy * 1.1), 0, img.h - 1);
+    int zy1 = clampInt(bestFaceY - (int)std::lround(bestRy * 0.15), 0, img.h - 1);
+
+    if (zx1 <= zx0 || zy1 <= zy0) {
+        out.eyesOk = false;
+        return out;
+    }
+
+    out.eyeRoiX = zx0;
+    out.eyeRoiY = zy0;
+    out.eyeRoiW = (zx1 - zx0 + 1);
+    out.eyeRoiH = (zy1 - zy0 + 1);
+
+    // Sub-image zoneYeux (view into img). Its gradient is a window of the frame field;
+    // by default the ROI's outer ring is recomputed clamped at the ROI, as the old
+    // per-ROI Sobel did, so border pixels keep their historical values.
+    grayView zoneYeux = sousVue(img, zx0, zy0, out.eyeRoiW, out.eyeRoiH);
+
+    Horloge::time_point t0;
+    VueGradient gradsYeux = sousVueGradient(grads, zx0, zy0, zoneYeux.w, zoneYeux.h);
+    if (!moteur.bordRoiImage) {
+        t0 = Horloge::now();
+        gradientRoiBordsClamp(grads, img, zx0, zy0, zoneYeux.w, zoneYeux.h, seuilEye, ws.gradsRoi);
+        gradsYeux = vueGradient(ws.gradsRoi);
+        noterEtape(mesures, "bord_roi", "yeux", -1, t0);
+    }
+    t0 = Horloge::now();
+    extraireBords(gradsYeux, seuilEye, ws.bordsYeux, ws.brut);
+    const ListeBords& bordsYeux = ws.bordsYeux;
+    noterEtape(mesures, "bords", "yeux", -1, t0);
+
+    rayonsPourVisage(eyeModels, bestRx, moteur, ws.rayons);
+    if (facteur > 1) yeuxPyramide(zoneYeux, eyeModels, seuilEye, moteur, mesures, ws);
+    const std::vector<size_t>& rayons = ws.rayons;
+
+    // for each radius model, pick best peaks list, keep global best (model order, as above)
+    if (ws.yeux.size() < rayons.size()) ws.yeux.resize(rayons.size());
+    pourChaqueModele(moteur, rayons.size(), [&](size_t i) {
+        const size_t mi = rayons[i];
+        EspaceTravail::Modele& v = ws.yeux[i];
+        v.m.etapes.clear();
+        MesuresDetection* m = mesures ? &v.m : nullptr;
+        preparerAccu(v.A, zoneYeux.w, zoneYeux.h);
+        uint64_t votes = 0, cellules = 0;
+        v.suivi.seuil = eyeMinPeak;
+        RTable tmp;
+        const RTable& lut = lutOeil(eyeModels[mi], moteur, 1, tmp);
+        Horloge::time_point t = Horloge::now();
+        voter(v.A, bordsYeux, lut, &votes, moteur.pool, tuilesVote(moteur, bordsYeux), &v.suivi, &v.tampon);
+        noterEtape(m, "voter", "yeux", (int)mi, t, bordsYeux.taille(), votes);
+
+        if (moteur.baryIntegrale) {
+            t = Horloge::now();
+            integralesAccu(v.A, v.integrales);
+            noterEtape(m, "integrales", "yeux", (int)mi, t, 0, 0, (uint64_t)v.A.w * (uint64_t)v.A.h);
+        }
+        t = Horloge::now();
+        topKpicsAvecBary(v.A, v.suivi, /*k*/6, /*nmsRadius*/eyeModels[mi].r * 2, /*baryRadius*/6,
+                         v.pics, v.cands, &cellules, moteur.baryIntegrale ? &v.integrales : nullptr);
+        noterEtape(m, "topk", "yeux", (int)mi, t, 0, 0, cellules);
+    });
+
+    uint16_t bestEyePeak = 0;
+    int bestR = 0;
+    int bestEye = -1;
+
+    for (size_t i = 0; i < rayons.size(); ++i) {
+        const std::vector<PicPoint>& pics = ws.yeux[i].pics;
+        if (mesures) fusionnerMesures(*mesures, ws.yeux[i].m);
+        if (pics.empty()) continue;
+
+        uint16_t localPeak = 0;
+        for (auto& p : pics) localPeak = std::max<uint16_t>(localPeak, p.v);
+
+        if (localPeak >= bestEyePeak) {
+            bestEyePeak = localPeak;
+            bestR = eyeModels[rayons[i]].r;
+            bestEye = (int)i;
+        }
+    }
+
+    if (bestEye < 0) {
+        out.eyesOk = false;
+        return out;
+    }
+    ws.accuYeux = &ws.yeux[(size_t)bestEye].A;
+    const std::vector<PicPoint>& bestPics = ws.yeux[(size_t)bestEye].pics;
+    if (bestPics.empty()) {
+        out.eyesOk = false;
+        return out;
+    }
+
+    // pair selection constraints based on face size
+    PicPoint og, od;
+    int minDx = std::max(10, (int)std::lround(bestRx * 0.55));
+    int maxDx = std::max(minDx + 10, (int)std::lround(bestRx * 1.60));
+    int maxDy = std::max(10, (int)std::lround(bestRy * 0.30));
+
+    t0 = Horloge::now();
+    bool pairOk = choisirPaireYeux(bestPics, bestFaceX - zx0, bestFaceY - zy0, minDx, maxDx, maxDy, og, od);
+    noterEtape(mesures, "paire", "yeux", -1, t0);
+    if (!pairOk) {
+        out.eyesOk = false;
+        return out;
+    }
+
+    out.eyesOk = true;
+    out.eyeR = bestR;
+
+    out.ex1 = zx0 + (int)std::lround(og.bx);
+    out.ey1 = zy0 + (int)std::lround(og.by);
+    out.ex2 = zx0 + (int)std::lround(od.bx);
+    out.ey2 = zy0 + (int)std::lround(od.by);
+
+    return out;
+}
+
+faceeyes detectfaceeyesGradient(
+    const grayView& img,
+    ChampGradient grads,
+    const std::vector<facemodel>& faceModels,
+    const std::vector<eyemodel>& eyeModels,
+    uint16_t seuilFace, uint16_t seuilEye,
+    uint16_t faceMinScore, uint16_t eyeMinPeak,
+    const OptionsMoteur& moteur,
+    MesuresDetection* mesures
+) {
+    if (!tailleImageValide(img.w, img.h)) {
+        faceeyes out;
+        out.dbgGrads = std::move(grads);
+        return out;
+    }
+    EspaceTravail ws;
+    ws.grads = std::move(grads);
+    faceeyes out = detectfaceeyesGradient(img, ws, faceModels, eyeModels, seuilFace, seuilEye,
+                                          faceMinScore, eyeMinPeak, moteur, mesures);
+
+    out.dbgFaceAccuOk = true;
+    if (ws.accuFace && ws.accuFace->w == img.w && ws.accuFace->h == img.h) {
+        out.dbgFaceAccu = std::move(*ws.accuFace);
+    } else {
+        // pyramid: the refined window region, at its place in a frame-sized accumulator
+        out.dbgFaceAccu = makeAccu(img.w, img.h);
+        if (ws.accuFace) {
+            const AccuImage& A = *ws.accuFace;
+            for (int y = 0; y < A.h; ++y) {
+                std::copy_n(&A.a[(size_t)y * (size_t)A.w], (size_t)A.w,
+                            &out.dbgFaceAccu.at(ws.accuFaceY0 + y, ws.accuFaceX0));
+            }
+        }
+    }
+    // the eye accumulator exists once the eye ROI is set
+    out.dbgEyeAccuOk = out.eyeRoiW > 0;
+    if (ws.accuYeux) out.dbgEyeAccu = std::move(*ws.accuYeux);
+    else if (out.dbgEyeAccuOk) out.dbgEyeAccu = makeAccu(out.eyeRoiW, out.eyeRoiH);
+    out.dbgGrads = std::move(ws.grads);
+    return out;
+}
+
+// -------------------- model bank --------------------
+BanqueModeles construireBanqueModeles(int nEchellesFace) {
+    BanqueModeles banque;
+    {
+        std::vector<std::pair<int, int>> scales = {
+            {25, 45}, {30, 55}, {35, 65}, {45, 85}, {55, 105}, {65, 125}, {75, 145}
+        };
+        if (nEchellesFace >= 2) {
+            scales.clear();
+            for (int i = 0; i < nEchellesFace; ++i) {
+                int rx = 25 + (int)std::lround(50.0 * i / (nEchellesFace - 1));
+                if (!scales.empty() && scales.back().first == rx) continue;
+                scales.push_back({rx, 2 * rx - 5});
+            }
+        }
+        for (const auto& sc : scales) {
+            int rx = sc.first;
+            int ry = sc.second;
+            int tw = 2 * rx + 60;
+            int th = 2 * ry + 60;
+
+            grayImage t = templateEllipse(tw, th, (float)rx, (float)ry);
+            RTable lut = construireRTableDepuisTemplate(t, 50, 220);
+
+            facemodel fm;
+            fm.rx = rx; fm.ry = ry; fm.lut = lut;
+            fm.reduites = {reduireRTable(lut, 2), reduireRTable(lut, 4)};
+            fm.ellipse = rtableEllipse((float)rx, (float)ry);
+            fm.ellipsesReduites = {rtableEllipse((float)rx / 2.0f, (float)ry / 2.0f),
+                                   rtableEllipse((float)rx / 4.0f, (float)ry / 4.0f)};
+            banque.faces.push_back(fm);
+        }
+    }
+
+    {
+        for (int r = 6; r <= 18; r += 2) {
+            int tw = 2 * r + 40;
+            int th = 2 * r + 40;
+
+            grayImage t = templateCercle(tw, th, (float)r);
+            RTable lut = construireRTableDepuisTemplate(t, 40, 220);
+
+            eyemodel em;
+            em.r = r; em.lut = lut;
+            em.reduites = {reduireRTable(lut, 2), reduireRTable(lut, 4)};
+            em.cercle = rtableCercle((float)r);
+            em.cerclesReduits = {rtableCercle((float)r / 2.0f), rtableCercle((float)r / 4.0f)};
+            banque.yeux.push_back(em);
+        }
+    }
+    return banque;
+}
+
+// -------------------- preprocessing + thresholds --------------------
+int normaliserBlurK(int blurK) {
+    if (blurK <= 0) return blurK;
+    if (blurK % 2 == 0) blurK += 1;
+    return std::max(1, blurK);
+}
+
+cv::Mat pretraiter(const cv::Mat& src, const OptionsDetection& opt, bool enPlace) {
+    cv::Mat tampon;
+    return pretraiter(src, opt, enPlace, tampon);
+}
+
+cv::Mat pretraiter(const cv::Mat& src, const OptionsDetection& opt, bool enPlace, cv::Mat& tampon,
+                   cv::Ptr<cv::CLAHE>* clahe) {
+    cv::Mat gray;
+    if (src.channels() == 3) {
+        cv::cvtColor(src, tampon, cv::COLOR_BGR2GRAY);
+        gray = tampon;
+        enPlace = true;
+    } else {
+        gray = src;
+    }
+
+    cv::Mat& dst = enPlace ? gray : tampon;
+    if (opt.useClahe) {
+        cv::Ptr<cv::CLAHE> local;
+        cv::Ptr<cv::CLAHE>& c = clahe ? *clahe : local;
+        if (!c) c = cv::createCLAHE(2.0, cv::Size(8, 8));
+        c->apply(gray, dst);
+        gray = dst;
+    } else if (opt.useEqHist) {
+        cv::equalizeHist(gray, dst);
+        gray = dst;
+    }
+
+    int blurK = normaliserBlurK(opt.blurK);
+    if (blurK > 0) {
+        cv::GaussianBlur(gray, dst, cv::Size(blurK, blurK), 0.0);
+        gray = dst;
+    }
+    return gray;
+}
+
+bool seuilsAutomatiques(const OptionsDetection& opt) {
+    return opt.autoThr && opt.faceEdgeUser < 0 && opt.eyeEdgeUser < 0;
+}
+
+Seuils calculerSeuils(const ChampGradient& cg, const OptionsDetection& opt, std::vector<uint32_t>* echantillons) {
+    Seuils s;
+    if (opt.faceEdgeUser >= 0) s.edgeFace = (uint16_t)clampInt(opt.faceEdgeUser, 0, 65535);
+    if (opt.eyeEdgeUser  >= 0) s.edgeEye  = (uint16_t)clampInt(opt.eyeEdgeUser, 0, 65535);
+    if (opt.faceMinUser  >= 0) s.faceMinScore = (uint16_t)clampInt(opt.faceMinUser, 0, 65535);
+    if (opt.eyeMinUser   >= 0) s.eyeMinPeak   = (uint16_t)clampInt(opt.eyeMinUser, 0, 65535);
+
+    // Auto thresholds based on gradient percentiles
+    if (seuilsAutomatiques(opt)) {
+        // These heuristics are designed to prevent "no votes" on low-contrast frames.
+        // p90 tends to be "strong edges"; we pick fractions for face/eyes.
+        uint16_t p90 = echantillons ? magPercentile(cg, 0.90, *echantillons) : magPercentile(cg, 0.90);
+        uint16_t p80 = echantillons ? magPercentile(cg, 0.80, *echantillons) : magPercentile(cg, 0.80);
+
+        // guard rails
+        s.edgeFace = (uint16_t)clampInt((int)std::lround((double)p90 * 0.70), 20, 600);
+        s.edgeEye  = (uint16_t)clampInt((int)std::lround((double)p80 * 0.55), 15, 500);
+    }
+    return s;
+}
+
+faceeyes analyser(
+    const cv::Mat& src,
+    const BanqueModeles& banque,
+    const OptionsDetection& opt,
+    Seuils& seuils,
+    cv::Mat* grayOut,
+    bool enPlace,
+    MesuresDetection* mesures,
+    EspaceTravail* ws
+) {
+    if (!tailleImageValide(src.cols, src.rows)) return faceeyes();
+    EspaceTravail local;
+    EspaceTravail& e = ws ? *ws : local;
+    Horloge::time_point t0 = Horloge::now();
+    cv::Mat gray = pretraiter(src, opt, enPlace, e.gris, &e.clahe);
+    noterEtape(mesures, "pretraiter", "frame", -1, t0);
+    grayView g = matToGrayView(gray);
+    if (grayOut) *grayOut = gray;
+
+    // one full-frame gradient feeds the thresholds, the face stage and the eye ROI
+    // (fixed thresholds are known up front; auto ones need the magnitudes first, so the
+    // fast path fills its angles in a second pass)
+    const bool rapide = opt.moteur.gradientRapide;
+    const bool autoSeuils = seuilsAutomatiques(opt);
+    if (!autoSeuils) seuils = calculerSeuils(ChampGradient(), opt);
+    t0 = Horloge::now();
+    ChampGradient& grads = e.grads;
+    if (!rapide) sobel(g, grads, e.lignesSobel);
+    else sobelRapide(g, grads, e.lignesSobel, autoSeuils ? (uint16_t)65535 : std::min(seuils.edgeFace, seuils.edgeEye));
+    noterEtape(mesures, "sobel", "frame", -1, t0);
+
+    if (autoSeuils) {
+        seuils = calculerSeuils(grads, opt, &e.echantillons);
+        if (rapide) {
+            t0 = Horloge::now();
+            completerAngles(grads, g, std::min(seuils.edgeFace, seuils.edgeEye));
+            noterEtape(mesures, "angles", "frame", -1, t0);
+        }
+    }
+    if (ws) {
+        return detectfaceeyesGradient(g, *ws, banque.faces, banque.yeux,
+                                      seuils.edgeFace, seuils.edgeEye, seuils.faceMinScore, seuils.eyeMinPeak,
+                                      opt.moteur, mesures);
+    }
+    return detectfaceeyesGradient(g, std::move(grads), banque.faces, banque.yeux,
+                                  seuils.edgeFace, seuils.edgeEye, seuils.faceMinScore, seuils.eyeMinPeak,
+                                  opt.moteur, mesures);
+}
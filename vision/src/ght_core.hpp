@@ -0,0 +1,651 @@
+// FILE: vision/src/ght_core.hpp
+// Detection core shared by ght_face_eyes and libght: image/gradient/accumulator
+// types, GHT voting, peak extraction, model bank and the preprocessing pipeline.
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class PoolTaches;
+namespace cv { class CLAHE; }
+
+// -------------------- utils --------------------
+inline int clampInt(int v, int minV, int maxV) {
+    if (v < minV) return minV;
+    if (v > maxV) return maxV;
+    return v;
+}
+
+// -------------------- image struct --------------------
+struct grayImage {
+    int w = 0, h = 0;
+    std::vector<uint8_t> p;
+
+    uint8_t& at(int y, int x) { return p[(size_t)y * (size_t)w + (size_t)x]; }
+    uint8_t  at(int y, int x) const { return p[(size_t)y * (size_t)w + (size_t)x]; }
+};
+
+// Non-owning view over 8-bit gray pixels with an explicit row stride
+// (cv::Mat rows, raw frames, shared-memory slots, sub-rectangles).
+struct grayView {
+    int w = 0, h = 0;
+    size_t stride = 0;
+    const uint8_t* p = nullptr;
+
+    uint8_t at(int y, int x) const { return p[(size_t)y * stride + (size_t)x]; }
+};
+
+grayView vue(const grayImage& g);
+grayView sousVue(const grayView& g, int x0, int y0, int w, int h);
+// grayU8 must be CV_8UC1; the view borrows its rows (no copy).
+grayView matToGrayView(const cv::Mat& grayU8);
+
+// -------------------- gradients --------------------
+struct ChampGradient {
+    int w = 0, h = 0;
+    std::vector<uint16_t> mag; // magnitude
+    std::vector<uint16_t> ang; // angle bins [0..359]
+    std::vector<uint32_t> mag2; // sobelRapide(): gx^2+gy^2 instead of mag (mag left empty)
+
+    bool carre() const { return !mag2.empty(); }
+
+    uint16_t& m(int y, int x) { return mag[(size_t)y * (size_t)w + (size_t)x]; }
+    uint16_t  m(int y, int x) const { return mag[(size_t)y * (size_t)w + (size_t)x]; }
+
+    uint16_t& a(int y, int x) { return ang[(size_t)y * (size_t)w + (size_t)x]; }
+    uint16_t  a(int y, int x) const { return ang[(size_t)y * (size_t)w + (size_t)x]; }
+
+    // rounded magnitude whichever field is filled (GUI/debug; not for hot loops)
+    uint16_t magnitude(int y, int x) const;
+};
+
+// lround(sqrt(s)) >= T  <=>  s >= seuilCarre(T). Exact: for s <= 2*1020^2 the float
+// sqrt of an integer never rounds onto a .5 tie.
+inline uint32_t seuilCarre(uint16_t T) { return T ? (uint32_t)T * T - T + 1 : 0; }
+
+ChampGradient sobel(const grayView& img);
+// Same into cg, reusing its storage; lignes is the gx/gy row scratch (2 * img.w).
+void sobel(const grayView& img, ChampGradient& cg, std::vector<int16_t>& lignes);
+
+// Fast gradient: squared magnitudes in mag2 and angle bins from an octant/ratio LUT
+// (same bins as sobel(), atan2 only inside a thin guard band around bin edges).
+// Angles are only computed where the magnitude reaches seuilAngle; elsewhere they are 0.
+ChampGradient sobelRapide(const grayView& img, uint16_t seuilAngle = 0);
+void sobelRapide(const grayView& img, ChampGradient& cg, std::vector<int16_t>& lignes, uint16_t seuilAngle = 0);
+
+// Angle bin of one (gx, gy): atan2 as in sobel(), and the LUT path of sobelRapide() (tests).
+uint16_t binSobel(int gx, int gy);
+uint16_t binSobelRapide(int gx, int gy);
+
+// sobelRapide() field: (re)computes the angle of every pixel whose magnitude reaches seuilAngle.
+void completerAngles(ChampGradient& cg, const grayView& img, uint16_t seuilAngle);
+
+// Strided window into a ChampGradient: the eye ROI reads the full-frame field, no copy.
+struct VueGradient {
+    int w = 0, h = 0;
+    size_t stride = 0;
+    const uint16_t* mag = nullptr;   // null for a squared (sobelRapide) field
+    const uint32_t* mag2 = nullptr;  // null for an exact (sobel) field
+    const uint16_t* ang = nullptr;
+};
+
+VueGradient vueGradient(const ChampGradient& cg);
+VueGradient sousVueGradient(const ChampGradient& cg, int x0, int y0, int w, int h);
+
+// Copy of window (x0,y0,w,h) of cg (computed on img) whose one-pixel ring is recomputed with
+// reads clamped to the window: same field as sobel()/sobelRapide() run on sousVue(img, ...).
+ChampGradient gradientRoiBordsClamp(const ChampGradient& cg, const grayView& img,
+                                    int x0, int y0, int w, int h, uint16_t seuilAngle);
+void gradientRoiBordsClamp(const ChampGradient& cg, const grayView& img,
+                           int x0, int y0, int w, int h, uint16_t seuilAngle, ChampGradient& r);
+
+// Instruction set used by sobel() ("avx2", "sse4.1" or "scalar"), chosen once at runtime.
+const char* sobelIsa();
+
+// Raw gx/gy of sobel(), row-major w x h, through the same kernels (tests, debug views).
+void composantesSobel(const grayView& img, std::vector<int16_t>& gx, std::vector<int16_t>& gy);
+
+// -------------------- pyramid --------------------
+// Box mean over facteur x facteur blocks (floor size): reduced pixel X covers full-size
+// pixels [facteur * X, facteur * X + facteur - 1].
+grayImage reduireImage(const grayView& img, int facteur);
+// Same into r's storage.
+void reduireImage(const grayView& img, int facteur, grayImage& r);
+
+// -------------------- accumulator + R-Table --------------------
+struct AccuImage {
+    int w = 0, h = 0;
+    std::vector<uint16_t> a;
+
+    uint16_t& at(int y, int x) { return a[(size_t)y * (size_t)w + (size_t)x]; }
+    uint16_t  at(int y, int x) const { return a[(size_t)y * (size_t)w + (size_t)x]; }
+};
+
+AccuImage makeAccu(int w, int h);
+// Zeroed w x h accumulator in A's storage (no allocation once it is large enough).
+void preparerAccu(AccuImage& A, int w, int h);
+
+// Face accumulator over (x, y, scale), scale-major: scale s is the plain w x h accumulator
+// plans[s]. Each scale is voted straight into its plane, the rows of a band tile form one
+// contiguous block of every plane, and the winning scale is handed out as is.
+struct VolumeAccu {
+    int w = 0, h = 0, n = 0;
+    std::vector<AccuImage> plans;
+
+    uint16_t& at(int y, int x, int s) { return plans[(size_t)s].at(y, x); }
+    uint16_t  at(int y, int x, int s) const { return plans[(size_t)s].at(y, x); }
+};
+
+VolumeAccu makeVolume(int w, int h, int n);
+
+// Zeroed w x h x n volume in V's storage, as preparerAccu().
+void preparerVolume(VolumeAccu& V, int w, int h, int n);
+
+// Flattened (CSR) R-table: angle bin b owns offsets [debut[b], debut[b + 1]) of dx/dy.
+// The boxes bound the offsets of each bin and of the whole model (vote footprint): a pixel
+// whose footprint lies inside the accumulator votes without per-vote bounds checks.
+struct RTable {
+    std::array<uint32_t, 361> debut{};
+    std::vector<int16_t> dx, dy;
+    std::array<int16_t, 360> dxMin{}, dxMax{}, dyMin{}, dyMax{};  // empty bin: all 0
+    int16_t dxMinModele = 0, dxMaxModele = 0, dyMinModele = 0, dyMaxModele = 0;
+
+    uint32_t taille(size_t b) const { return debut[b + 1] - debut[b]; }
+};
+
+// angle bin -> list of (dx, dy), the construction-time form of an RTable
+using ListesRTable = std::array<std::vector<std::pair<int16_t, int16_t>>, 360>;
+
+RTable rtableDepuisListes(const ListesRTable& bins);
+
+RTable construireRTableDepuisTemplate(const grayImage& templ, uint16_t minMag, uint16_t maxMag);
+
+// R-table for an image reduced by facteur: offsets divided (rounded), duplicates of a bin
+// merged. Angle bins do not change with scale.
+RTable reduireRTable(const RTable& rt, int facteur);
+
+// Analytic circle table (gradient-directed circle Hough): for each angle bin theta, the
+// centre of a dark disk of radius r lies at -r * (cos theta, sin theta) from the edge pixel,
+// since the gradient points out of the disk. One offset per bin, no template.
+RTable rtableCercle(float r);
+
+// Analytic axis-aligned ellipse table: the boundary point of angle phi, (rx cos phi, ry sin phi),
+// has its normal along theta with tan phi = (ry / rx) tan theta. The edge polarity of a face
+// against its background is unknown, so each bin holds both centres, at +- that point.
+RTable rtableEllipse(float rx, float ry);
+
+// Edge pixels of a gradient window (magnitude >= threshold), bucketed by angle bin with a
+// counting sort. Built once per frame and stage, then shared by every model: voter()
+// applies each R-table bin to one contiguous pixel group. Buckets are per horizontal band
+// of kHauteurBandeBords rows so the votes of a group stay in a cache-sized slice of the
+// accumulator; raster order is kept inside a group.
+static const int kHauteurBandeBords = 32;
+
+// Largest frame side the detector accepts: edge coordinates are stored as int16.
+static const int kCoteMaxImage = 32767;
+inline bool tailleImageValide(int w, int h) { return w <= kCoteMaxImage && h <= kCoteMaxImage; }
+
+struct ListeBords {
+    int w = 0, h = 0;                 // window size (accumulator size)
+    int nBandes = 0;
+    std::vector<int16_t> x, y;        // window coordinates (sides <= kCoteMaxImage)
+    std::vector<uint32_t> debut;      // group (band * 360 + bin) occupies [debut[g], debut[g + 1])
+
+    size_t taille() const { return x.size(); }
+};
+
+ListeBords extraireBords(const VueGradient& grads, uint16_t seuilMag);
+
+// Same into L, reusing its storage; brut is the raster-order scratch of the bucket sort.
+struct BordBrut { int16_t x, y; uint32_t g; };
+void extraireBords(const VueGradient& grads, uint16_t seuilMag, ListeBords& L, std::vector<BordBrut>& brut);
+
+// Peak statistics kept while voting into a zeroed accumulator, so peak pickers need no
+// full rescan: the max and its raster-last cell (what a `>=` raster scan returns; the
+// last cell when nothing was voted) and the cells whose count reached seuil.
+struct SuiviPic {
+    uint16_t seuil = 0;              // in: collect cells >= seuil (0 = no list)
+    uint16_t peak = 0;
+    int px = 0, py = 0;
+    std::vector<uint32_t> auDessus;  // y * w + x, in no particular order
+};
+
+// Scratch of voter() kept by the caller across calls: the per-group pixel lists and, on a
+// pool, the band tiles (private accumulators) with their merge statistics. Each buffer
+// grows to the largest call and stays allocated.
+struct TamponVote {
+    struct Tuile {
+        int bande0 = 0, bande1 = 0, y0 = 0, y1 = 0;
+        std::vector<uint16_t> acc;
+        std::vector<uint32_t> groupes;
+        uint64_t votes = 0;
+    };
+    struct Stats { uint16_t pic = 0; size_t idx = 0; std::vector<uint32_t> auDessus; };
+    std::vector<uint32_t> groupes;
+    std::vector<Tuile> tuiles;
+    std::vector<Stats> stats;
+};
+
+// With a pool and tuiles > 1, bands of the list are voted in parallel into private
+// accumulators (band rows + footprint halo) and merged with saturation; same result.
+// With suivi, A must be zeroed on entry. Without tampon, scratch is allocated per call.
+void voter(
+    AccuImage& A,
+    const ListeBords& bords,
+    const RTable& rtable,
+    uint64_t* nVotes = nullptr,
+    PoolTaches* pool = nullptr,
+    int tuiles = 1,
+    SuiviPic* suivi = nullptr,
+    TamponVote* tampon = nullptr
+);
+
+void voter(
+    AccuImage& A,
+    const VueGradient& grads,
+    const RTable& rtable,
+    uint16_t seuilMag,
+    uint64_t* nBords = nullptr,
+    uint64_t* nVotes = nullptr
+);
+
+void voter(
+    AccuImage& A,
+    const grayView& img,
+    const ChampGradient& grads,
+    const RTable& rtable,
+    uint16_t seuilMag,
+    uint64_t* nBords = nullptr,   // optional: edge pixels above seuilMag
+    uint64_t* nVotes = nullptr    // optional: votes landing inside A
+);
+
+// Votes of tables[s] into scale s of V, for every s < V.n, straight into its plane. With a
+// pool and tuiles > 1, bands are voted in parallel into private slabs (one block of rows
+// per scale) and merged with saturation, as voter(). V must be zeroed on entry; pic
+// receives its max. Without tampon, scratch is allocated per call.
+void voterVolume(
+    VolumeAccu& V,
+    const ListeBords& bords,
+    const std::vector<const RTable*>& tables,
+    uint64_t* nVotes = nullptr,
+    PoolTaches* pool = nullptr,
+    int tuiles = 1,
+    uint16_t* pic = nullptr,
+    TamponVote* tampon = nullptr
+);
+
+// Summed-area tables of A, x·A and y·A over (w + 1) x (h + 1) corners, interleaved per
+// corner, built in one pass. Any window sum is then four lookups per table, exact in
+// integers: barycentres cost O(1) whatever the window radius or the number of peaks.
+struct IntegralesAccu {
+    int w = 0, h = 0;
+    std::vector<uint64_t> t;  // corner (y, x) -> t[3 * (y * (w + 1) + x) + {0: A, 1: x·A, 2: y·A}]
+
+    bool vide() const { return t.empty(); }
+};
+
+IntegralesAccu integralesAccu(const AccuImage& A);
+void integralesAccu(const AccuImage& A, IntegralesAccu& I);
+
+struct PicBary {
+    bool ok = false;
+    float bx = 0.0f, by = 0.0f;
+    uint16_t peak = 0;
+};
+
+// With integrales (built on A), window sums come from the tables instead of the cells.
+PicBary barycentreLocalAutourMax(const AccuImage& A, int radius, uint64_t* nCellules = nullptr,
+                                 const IntegralesAccu* integrales = nullptr);
+// Same, with the max already known from voting (no accumulator scan).
+PicBary barycentreLocalAutourMax(const AccuImage& A, const SuiviPic& suivi, int radius, uint64_t* nCellules = nullptr,
+                                 const IntegralesAccu* integrales = nullptr);
+
+// Joint peak of a volume: max cell over (x, y, s) (raster-last pixel on ties, then the
+// largest scale at that pixel). Around
+// it, (bx, by) is the barycentre of the (2 radius + 1)^2 window on the peak's scale, as
+// per-scale accumulators give it, and bs the fractional scale index weighted over that
+// window on the 2 rayonEchelle + 1 neighbouring scales; s is the peak cell's scale.
+struct PicVolume {
+    bool ok = false;
+    float bx = 0.0f, by = 0.0f, bs = 0.0f;
+    int s = 0;
+    uint16_t peak = 0;
+};
+
+// With pic (the max, from voterVolume()), the peak cell is found scanning each plane back
+// from its end.
+PicVolume picVolume(const VolumeAccu& V, int radius, int rayonEchelle, uint64_t* nCellules = nullptr,
+                    const uint16_t* pic = nullptr);
+
+struct PicPoint {
+    int x = 0, y = 0;
+    float bx = 0.0f, by = 0.0f;
+    uint16_t v = 0;
+};
+
+// Up to k peaks >= minVal, greedy NMS (each farther than nmsRadius from the better ones
+// kept), best first, each with its barycenter. Candidates are taken by value descending,
+// then raster order (y, then x) on equal values: a total order, so the picks do not
+// depend on the standard library's sort. Cost: O(candidates) selection plus sorting the
+// blocks actually consumed (usually one of max(512, 64 k)).
+std::vector<PicPoint> topKpicsAvecBary(
+    const AccuImage& A,
+    int k,
+    int nmsRadius,
+    int baryRadius,
+    uint16_t minVal,
+    uint64_t* nCellules = nullptr,  // optional: accumulator cells read
+    const IntegralesAccu* integrales = nullptr
+);
+
+// Same, with the candidates (cells >= suivi.seuil, the minVal) collected while voting.
+std::vector<PicPoint> topKpicsAvecBary(
+    const AccuImage& A,
+    const SuiviPic& suivi,
+    int k,
+    int nmsRadius,
+    int baryRadius,
+    uint64_t* nCellules = nullptr,
+    const IntegralesAccu* integrales = nullptr
+);
+
+// Same into out, with the candidate scratch kept by the caller.
+struct Candidat { int x, y; uint16_t v; };
+void topKpicsAvecBary(
+    const AccuImage& A,
+    const SuiviPic& suivi,
+    int k,
+    int nmsRadius,
+    int baryRadius,
+    std::vector<PicPoint>& out,
+    std::vector<Candidat>& cands,
+    uint64_t* nCellules = nullptr,
+    const IntegralesAccu* integrales = nullptr
+);
+
+// pair selection
+bool choisirPaireYeux(
+    const std::vector<PicPoint>& pics,
+    int faceCxInZone,
+    int faceCyInZone,
+    int minDx, int maxDx,
+    int maxDy,
+    PicPoint& oeilGauche,
+    PicPoint& oeilDroit
+);
+
+// -------------------- models --------------------
+// reduites, ellipsesReduites, cerclesReduits: tables for 1/2 and 1/4 images (pyramid
+// mode); left empty, they are derived per call
+struct facemodel {
+    int rx = 0, ry = 0;
+    RTable lut;
+    std::array<RTable, 2> reduites;
+    RTable ellipse;
+    std::array<RTable, 2> ellipsesReduites;
+};
+struct eyemodel {
+    int r = 0;
+    RTable lut;
+    std::array<RTable, 2> reduites;
+    RTable cercle;
+    std::array<RTable, 2> cerclesReduits;
+};
+
+// -------------------- adaptive threshold helper --------------------
+uint16_t magPercentile(const ChampGradient& cg, double q /*0..1*/);
+// Same with the sample buffer kept by the caller.
+uint16_t magPercentile(const ChampGradient& cg, double q, std::vector<uint32_t>& echantillons);
+
+struct faceeyes {
+    bool faceOk = false;
+    int faceX = 0, faceY = 0;
+    int faceRx = 0, faceRy = 0;
+
+    int eyeRoiX = 0, eyeRoiY = 0, eyeRoiW = 0, eyeRoiH = 0;
+
+    bool eyesOk = false;
+    int ex1 = 0, ey1 = 0, ex2 = 0, ey2 = 0;
+    int eyeR = 0;
+
+    // debug
+    ChampGradient dbgGrads;
+    bool dbgFaceAccuOk = false;
+    AccuImage dbgFaceAccu;
+    bool dbgEyeAccuOk = false;
+    AccuImage dbgEyeAccu;
+};
+
+// -------------------- timings (--timings) --------------------
+// One entry per measured call, in call order. Filled only when a MesuresDetection is passed.
+struct MesureEtape {
+    const char* etape = "";   // imread, pretraiter, sobel, voter, barycentre, topk, paire
+    const char* cible = "";   // frame, seuils, yeux, face
+    int modele = -1;          // index in the model bank (voter/barycentre/topk), -1 otherwise
+    double us = 0.0;          // wall time, microseconds
+    uint64_t bords = 0;       // voter: edge pixels above seuilMag
+    uint64_t votes = 0;       // voter: votes cast into the accumulator
+    uint64_t cellules = 0;    // barycentre/topk: accumulator cells read
+};
+
+struct MesuresDetection {
+    std::vector<MesureEtape> etapes;
+};
+
+// -------------------- engine options --------------------
+// Process-wide detection engine knobs; preprocessing/thresholds live in OptionsDetection.
+struct OptionsMoteur {
+    bool gradientRapide = false;  // sobelRapide(): no per-pixel sqrt/atan2, same detections
+    // Eye ROI border ring: recomputed with reads clamped to the ROI (historical results),
+    // or read straight from the full-frame gradient (pure view, true image gradient).
+    bool bordRoiImage = false;
+    // Face scales / eye radii are voted concurrently on this pool (not owned; null = inline).
+    // The winner is still picked in model order, so results do not depend on thread count.
+    PoolTaches* pool = nullptr;
+    // Band tiles per voter() call (intra-model parallelism, private accumulators merged
+    // with saturation): 0 = auto (pool threads once the edge list is large), 1 = off.
+    int tuilesVote = 0;
+    // Barycentres from summed-area tables of the accumulator (one extra pass per model,
+    // then O(1) per peak): pays off once peak count x window area nears the accumulator
+    // size. Same results either way.
+    bool baryIntegrale = false;
+    // Coarse-to-fine search (1 = off, 2 or 4): face scales are voted on a 1/pyramide frame.
+    // When the coarse frame is decisive (no scale reaches a fixed fraction of the best
+    // coarse peak away from its own max), the best scale, its neighbours and the scales
+    // that reach that fraction are voted at full resolution in a window around their
+    // coarse max, the window following the max to the ridge top. Otherwise the full search
+    // runs ("repli" step), after the coarse pass: the face is always within a pixel of the
+    // full search's, with its scale (tests/test_pyramide.cpp), and noisy frames with
+    // near-tied peaks cost a little more than without the pyramid. Eye radii are ranked on
+    // the ROI at 1/2 under the same rule, only the best one and its neighbours being voted
+    // at full resolution.
+    int pyramide = 1;
+    // Adaptive face scale search (1 = vote every scale): every pasEchelles-th scale is voted
+    // first, then the best one is refined by probes at +-pas/2, +-pas/4, ... and +-1 steps
+    // while it moves: about n / pas + 2 * log2(pas) + 2 votes instead of n. Same winner as
+    // the full ladder as long as the true peak stays the best over pas neighbouring scales.
+    int pasEchelles = 1;
+    // Eye radii voted once the face scale is known: every eye model (ratioRayonOeilMax = 0),
+    // or only radii r with ratioRayonOeilMin * rx <= r <= ratioRayonOeilMax * rx, rx being
+    // the chosen face half-width (the closest radius when none falls inside).
+    float ratioRayonOeilMin = 0.0f;
+    float ratioRayonOeilMax = 0.0f;
+    // Eye votes from the analytic circle table of each radius (eyemodel::cercle, built from
+    // r when empty) instead of the ring template's R-table: one vote per edge pixel and
+    // radius instead of 2r..3r, same accumulators and peak search.
+    bool yeuxCercle = false;
+    // Face votes from the analytic ellipse table of each scale (facemodel::ellipse, built
+    // from rx, ry when empty) instead of the template band's R-table: two votes per edge
+    // pixel and scale whatever the band thickness.
+    bool visageEllipse = false;
+    // Face scales voted into one (x, y, scale) volume at full resolution, the face taken at
+    // its joint peak with a size interpolated between scales (faceRx, faceRy rounded).
+    // Every scale is voted (pasEchelles unused), straight into its plane of the volume:
+    // about the voting time of separate accumulators over the full ladder. The pyramid,
+    // when on, takes precedence (the CLI rejects both together, and --scale-step with it).
+    bool volumeFace = false;
+};
+
+// -------------------- per-thread workspace --------------------
+// Scratch buffers of one detecting thread, kept across frames. Each grows to the largest
+// frame (or eye ROI) seen and is then reused, so once warm a frame allocates nothing from
+// the gradient on, on the default engine path, the face volume and the pyramid, with or
+// without a pool (vote tiles live in each Modele's tampon), as long as timings are off;
+// analyser() adds none of its own (tests/test_allocations.cpp). Not covered: OpenCV's
+// internals in pretraiter() (cvtColor, equalizeHist, CLAHE and GaussianBlur write into
+// gris, but may allocate row buffers or worker jobs per call). One per detection in flight
+// (daemon connection, shared-memory ring, batch image), never shared.
+struct EspaceTravail {
+    // one face model, or one voted eye radius
+    struct Modele {
+        AccuImage A;
+        SuiviPic suivi;
+        PicBary b;
+        IntegralesAccu integrales;
+        TamponVote tampon;                // voter() scratch
+        std::vector<Candidat> cands;
+        std::vector<PicPoint> pics;
+        MesuresDetection m;
+    };
+
+    cv::Mat gris;                         // pretraiter() output
+    cv::Ptr<cv::CLAHE> clahe;             // pretraiter(), created on the first CLAHE frame
+    ChampGradient grads;                  // frame gradient
+    ChampGradient gradsRoi;               // eye ROI with its clamped border ring
+    std::vector<int16_t> lignesSobel;
+    std::vector<uint32_t> echantillons;   // magPercentile()
+    std::vector<BordBrut> brut;           // extraireBords()
+    ListeBords bordsFace, bordsYeux;
+    std::vector<Modele> faces, yeux;
+    VolumeAccu volume;                    // OptionsMoteur::volumeFace
+    TamponVote tamponVolume;              // voterVolume() scratch
+    std::vector<RTable> tmpVolume;        // derived face tables of the volume
+    std::vector<const RTable*> tablesVolume;
+    std::vector<char> vote;
+    std::vector<size_t> lot, rayons;
+
+    // OptionsMoteur::pyramide: reduced frame (or eye ROI), and the full-resolution
+    // refinement windows, each covering the frame from (x0, y0)
+    struct Fenetre {
+        AccuImage A;
+        int modele = -1;
+        int x0 = 0, y0 = 0, px = 0, py = 0;  // px, py: the window max, frame coordinates
+        PicBary b;
+        ListeBords bords;
+        std::vector<BordBrut> brut;
+        TamponVote tampon;
+        MesuresDetection m;
+    };
+    grayImage reduite;
+    ChampGradient gradsReduits;
+    ListeBords bordsReduits;
+    std::vector<Fenetre> fenetres;
+
+    // Best face scale and eye radius accumulators of the last frame (debug views), valid
+    // until the next detection; accuFace covers the frame from (accuFaceX0, accuFaceY0).
+    AccuImage* accuFace = nullptr;
+    AccuImage* accuYeux = nullptr;
+    int accuFaceX0 = 0, accuFaceY0 = 0;
+};
+
+faceeyes detectfaceeyes(
+    const grayView& img,
+    const std::vector<facemodel>& faceModels,
+    const std::vector<eyemodel>& eyeModels,
+    uint16_t seuilFace, uint16_t seuilEye,
+    uint16_t faceMinScore, uint16_t eyeMinPeak,
+    const OptionsMoteur& moteur = OptionsMoteur(),
+    MesuresDetection* mesures = nullptr
+);
+
+// Same as detectfaceeyes() on a frame whose gradient is already computed (kept as dbgGrads).
+// A squared field must have angles wherever the magnitude reaches min(seuilFace, seuilEye).
+faceeyes detectfaceeyesGradient(
+    const grayView& img,
+    ChampGradient grads,
+    const std::vector<facemodel>& faceModels,
+    const std::vector<eyemodel>& eyeModels,
+    uint16_t seuilFace, uint16_t seuilEye,
+    uint16_t faceMinScore, uint16_t eyeMinPeak,
+    const OptionsMoteur& moteur = OptionsMoteur(),
+    MesuresDetection* mesures = nullptr
+);
+
+// Same on ws.grads (gradient of img), every scratch buffer taken from ws. The debug fields
+// of the result stay empty: the gradient and accumulators are left in ws.
+faceeyes detectfaceeyesGradient(
+    const grayView& img,
+    EspaceTravail& ws,
+    const std::vector<facemodel>& faceModels,
+    const std::vector<eyemodel>& eyeModels,
+    uint16_t seuilFace, uint16_t seuilEye,
+    uint16_t faceMinScore, uint16_t eyeMinPeak,
+    const OptionsMoteur& moteur = OptionsMoteur(),
+    MesuresDetection* mesures = nullptr
+);
+
+// -------------------- model bank --------------------
+struct BanqueModeles {
+    std::vector<facemodel> faces;
+    std::vector<eyemodel> yeux;
+};
+
+// nEchellesFace: 0 = the historical 7-scale ladder {25,45} .. {75,145}; n >= 2 = n scales
+// with rx evenly spaced over [25, 75] and ry = 2 * rx - 5 (the same curve, finer steps).
+BanqueModeles construireBanqueModeles(int nEchellesFace = 0);
+
+// -------------------- preprocessing + thresholds --------------------
+struct OptionsDetection {
+    bool useEqHist = true;
+    bool useClahe = false;
+    int blurK = 5;               // odd, 0 disables
+    bool autoThr = true;
+    int faceEdgeUser = -1;
+    int eyeEdgeUser  = -1;
+    int faceMinUser  = -1;
+    int eyeMinUser   = -1;
+    OptionsMoteur moteur;
+};
+
+struct Seuils {
+    // Defaults (same as the historical baseline, overridden by auto-threshold)
+    uint16_t edgeFace = 140;
+    uint16_t edgeEye  = 75;
+    uint16_t faceMinScore = 14;
+    uint16_t eyeMinPeak   = 5;
+};
+
+int normaliserBlurK(int blurK);
+
+// src: 8-bit BGR or 8-bit gray. A gray input is only written to when enPlace is set
+// (shared-memory slot owned by the detector); otherwise it may be a caller's buffer.
+cv::Mat pretraiter(const cv::Mat& src, const OptionsDetection& opt, bool enPlace = false);
+// Same, writing into tampon (reused across frames) whenever the source may not be written;
+// clahe, when given, holds the CLAHE instance across frames (created on first use).
+cv::Mat pretraiter(const cv::Mat& src, const OptionsDetection& opt, bool enPlace, cv::Mat& tampon,
+                   cv::Ptr<cv::CLAHE>* clahe = nullptr);
+
+// True when the thresholds come from the gradient percentiles (no user EDGE_* override).
+bool seuilsAutomatiques(const OptionsDetection& opt);
+
+// cg: gradient of the preprocessed frame (only read when seuilsAutomatiques(opt)).
+Seuils calculerSeuils(const ChampGradient& cg, const OptionsDetection& opt,
+                      std::vector<uint32_t>* echantillons = nullptr);
+
+// Full pipeline on a BGR or gray frame: preprocess, thresholds, detection. A frame with a
+// side above kCoteMaxImage is not analysed (no face, seuils untouched).
+faceeyes analyser(
+    const cv::Mat& src,
+    const BanqueModeles& banque,
+    const OptionsDetection& opt,
+    Seuils& seuils,
+    cv::Mat* grayOut,
+    bool enPlace = false,
+    MesuresDetection* mesures = nullptr,
+    EspaceTravail* ws = nullptr     // reused buffers; the result then has no debug views
+);
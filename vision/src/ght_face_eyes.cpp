@@ -7,34 +7,39 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
-// -------------------- utils --------------------
-static int clampInt(int v, int minV, int maxV) {
-    if (v < minV) return minV;
-    if (v > maxV) return maxV;
-    return v;
-}
-
-static int binDeg(float radians) {
-    float deg = radians * 180.0f / float(M_PI);
-    int b = (int)std::lround(deg);
-    b = b % 360;
-    if (b < 0) b += 360;
-    return b;
-}
+#include "ght_core.hpp"
+#include "ght_pool.hpp"
 
+// -------------------- GUI helpers --------------------
 static void showStep(const std::string& name, const cv::Mat& m, bool steps, int delayMs) {
     cv::imshow(name, m);
     if (steps) {
@@ -44,35 +49,6 @@ static void showStep(const std::string& name, const cv::Mat& m, bool steps, int
     }
 }
 
-// -------------------- image struct --------------------
-struct grayImage {
-    int w = 0, h = 0;
-    std::vector<uint8_t> p;
-
-    uint8_t& at(int y, int x) { return p[(size_t)y * (size_t)w + (size_t)x]; }
-    uint8_t  at(int y, int x) const { return p[(size_t)y * (size_t)w + (size_t)x]; }
-};
-
-static grayImage makeGris(int w, int h, uint8_t value) {
-    grayImage g;
-    g.w = w;
-    g.h = h;
-    g.p.assign((size_t)w * (size_t)h, value);
-    return g;
-}
-
-static grayImage matToGrayImageU8(const cv::Mat& grayU8) {
-    grayImage g;
-    g.w = grayU8.cols;
-    g.h = grayU8.rows;
-    g.p.assign((size_t)g.w * (size_t)g.h, 0);
-    for (int y = 0; y < g.h; ++y) {
-        const uint8_t* row = grayU8.ptr<uint8_t>(y);
-        for (int x = 0; x < g.w; ++x) g.at(y, x) = row[x];
-    }
-    return g;
-}
-
 static cv::Mat toMatGray8(const grayImage& g) {
     cv::Mat m(g.h, g.w, CV_8UC1);
     for (int y = 0; y < g.h; ++y) {
@@ -82,54 +58,6 @@ static cv::Mat toMatGray8(const grayImage& g) {
     return m;
 }
 
-// -------------------- gradients --------------------
-struct ChampGradient {
-    int w = 0, h = 0;
-    std::vector<uint16_t> mag; // magnitude
-    std::vector<uint16_t> ang; // angle bins [0..359]
-
-    uint16_t& m(int y, int x) { return mag[(size_t)y * (size_t)w + (size_t)x]; }
-    uint16_t  m(int y, int x) const { return mag[(size_t)y * (size_t)w + (size_t)x]; }
-
-    uint16_t& a(int y, int x) { return ang[(size_t)y * (size_t)w + (size_t)x]; }
-    uint16_t  a(int y, int x) const { return ang[(size_t)y * (size_t)w + (size_t)x]; }
-};
-
-static ChampGradient sobel(const grayImage& img) {
-    ChampGradient cg;
-    cg.w = img.w;
-    cg.h = img.h;
-    cg.mag.assign((size_t)cg.w * (size_t)cg.h, 0);
-    cg.ang.assign((size_t)cg.w * (size_t)cg.h, 0);
-
-    auto at = [&](int y, int x) -> int {
-        x = clampInt(x, 0, img.w - 1);
-        y = clampInt(y, 0, img.h - 1);
-        return (int)img.at(y, x);
-    };
-
-    for (int y = 0; y < img.h; ++y) {
-        for (int x = 0; x < img.w; ++x) {
-            int gx =
-                -1 * at(y - 1, x - 1) + 1 * at(y - 1, x + 1) +
-                -2 * at(y,     x - 1) + 2 * at(y,     x + 1) +
-                -1 * at(y + 1, x - 1) + 1 * at(y + 1, x + 1);
-
-            int gy =
-                -1 * at(y - 1, x - 1) + -2 * at(y - 1, x) + -1 * at(y - 1, x + 1) +
-                 1 * at(y + 1, x - 1) +  2 * at(y + 1, x) +  1 * at(y + 1, x + 1);
-
-            float mag = std::sqrt((float)gx * (float)gx + (float)gy * (float)gy);
-            float ang = std::atan2((float)gy, (float)gx);
-
-            int im = (int)std::lround(mag);
-            cg.m(y, x) = (uint16_t)clampInt(im, 0, 65535);
-            cg.a(y, x) = (uint16_t)binDeg(ang);
-        }
-    }
-    return cg;
-}
-
 // For GUI: normalize magnitude to [0..255] by min/max (readable even when edges are weak)
 static cv::Mat toMatMag8_norm(const ChampGradient& cg) {
     cv::Mat m(cg.h, cg.w, CV_8UC1);
@@ -138,7 +66,7 @@ static cv::Mat toMatMag8_norm(const ChampGradient& cg) {
     uint16_t maxv = 0;
     for (int y = 0; y < cg.h; ++y) {
         for (int x = 0; x < cg.w; ++x) {
-            uint16_t v = cg.m(y, x);
+            uint16_t v = cg.magnitude(y, x);
             minv = std::min<uint16_t>(minv, v);
             maxv = std::max<uint16_t>(maxv, v);
         }
@@ -151,479 +79,766 @@ static cv::Mat toMatMag8_norm(const ChampGradient& cg) {
     for (int y = 0; y < cg.h; ++y) {
         uint8_t* row = m.ptr<uint8_t>(y);
         for (int x = 0; x < cg.w; ++x) {
-            float f = (float)(cg.m(y, x) - minv) / (float)(maxv - minv);
+            float f = (float)(cg.magnitude(y, x) - minv) / (float)(maxv - minv);
             row[x] = (uint8_t)clampInt((int)std::lround(255.0f * f), 0, 255);
         }
     }
     return m;
 }
 
-// -------------------- accumulator + R-Table --------------------
-struct AccuImage {
-    int w = 0, h = 0;
-    std::vector<uint16_t> a;
+static cv::Mat toMatAccu8(const AccuImage& A) {
+    cv::Mat m(A.h, A.w, CV_8UC1);
+    uint16_t maxv = 1;
+    for (int y = 0; y < A.h; ++y)
+        for (int x = 0; x < A.w; ++x)
+            maxv = std::max<uint16_t>(maxv, A.at(y, x));
 
-    uint16_t& at(int y, int x) { return a[(size_t)y * (size_t)w + (size_t)x]; }
-    uint16_t  at(int y, int x) const { return a[(size_t)y * (size_t)w + (size_t)x]; }
-};
+    for (int y = 0; y < A.h; ++y) {
+        uint8_t* row = m.ptr<uint8_t>(y);
+        for (int x = 0; x < A.w; ++x) {
+            float f = (float)A.at(y, x) / (float)maxv;
+            row[x] = (uint8_t)clampInt((int)std::lround(255.0f * f), 0, 255);
+        }
+    }
+    return m;
+}
 
-static AccuImage makeAccu(int w, int h) {
-    AccuImage A;
-    A.w = w; A.h = h;
-    A.a.assign((size_t)w * (size_t)h, 0);
-    return A;
+static void drawOverlay(cv::Mat& frame, const faceeyes& r) {
+    if (r.faceOk) {
+        cv::circle(frame, cv::Point(r.faceX, r.faceY), 6, cv::Scalar(0, 255, 0), 2);
+    }
+    if (r.eyeRoiW > 0 && r.eyeRoiH > 0) {
+        cv::rectangle(frame, cv::Rect(r.eyeRoiX, r.eyeRoiY, r.eyeRoiW, r.eyeRoiH), cv::Scalar(255, 0, 0), 2);
+    }
+    if (r.eyesOk) {
+        cv::circle(frame, cv::Point(r.ex1, r.ey1), r.eyeR, cv::Scalar(0, 255, 255), 2);
+        cv::circle(frame, cv::Point(r.ex2, r.ey2), r.eyeR, cv::Scalar(0, 255, 255), 2);
+    }
 }
 
-struct RTable {
-    // angle bin -> list of (dx, dy)
-    std::array<std::vector<std::pair<int16_t, int16_t>>, 360> lut;
+// -------------------- raw frames --------------------
+// Uncompressed 8-bit frame: EnteteTrame, then pixel rows (row y starts at y * stride).
+// Used by --raw-stdin and by daemon requests of kind 3; skips any image codec.
+#pragma pack(push, 1)
+struct EnteteTrame {
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;     // bytes per row, width * channels .. + kTrameMargeStride
+    uint32_t channels;   // 1 = gray, 3 = BGR
 };
+#pragma pack(pop)
 
-static void voter(
-    AccuImage& A,
-    const grayImage& img,
-    const ChampGradient& grads,
-    const RTable& rtable,
-    uint16_t seuilMag
-) {
-    // vote for all pixels with sufficient gradient magnitude
-    for (int y = 0; y < img.h; ++y) {
-        for (int x = 0; x < img.w; ++x) {
-            uint16_t mag = grads.m(y, x);
-            if (mag < seuilMag) continue;
-            uint16_t ang = grads.a(y, x);
-            const auto& vec = rtable.lut[(size_t)ang];
-            if (vec.empty()) continue;
-
-            for (const auto& d : vec) {
-                int cx = x + d.first;
-                int cy = y + d.second;
-                if (cx < 0 || cy < 0 || cx >= A.w || cy >= A.h) continue;
-                uint16_t& cell = A.at(cy, cx);
-                if (cell < 65535) cell++;
-            }
-        }
-    }
+static const uint32_t kTrameCoteMax = 16384;
+// Row padding accepted past width * channels (aligned capture buffers); bounds the frame
+// size, hence the buffer stdin allocates, before any pixel is read.
+static const uint32_t kTrameMargeStride = 64;
+
+static size_t tailleTrame(const EnteteTrame& t) {
+    return (size_t)t.stride * (size_t)(t.height - 1) + (size_t)t.width * (size_t)t.channels;
 }
 
-struct PicBary {
-    bool ok = false;
-    float bx = 0.0f, by = 0.0f;
-    uint16_t peak = 0;
-};
+static bool trameValide(const EnteteTrame& t) {
+    if (t.channels != 1 && t.channels != 3) return false;
+    if (t.width == 0 || t.height == 0) return false;
+    if (t.width > kTrameCoteMax || t.height > kTrameCoteMax) return false;
+    return t.stride >= t.width * t.channels && t.stride - t.width * t.channels <= kTrameMargeStride;
+}
 
-static PicBary barycentreLocalAutourMax(const AccuImage& A, int radius) {
-    // find max
-    uint16_t peak = 0;
-    int px = 0, py = 0;
-    for (int y = 0; y < A.h; ++y) {
-        for (int x = 0; x < A.w; ++x) {
-            uint16_t v = A.at(y, x);
-            if (v >= peak) { peak = v; px = x; py = y; }
-        }
-    }
-    if (peak == 0) return PicBary{false, 0, 0, 0};
+// Wraps pixels in a cv::Mat header without copying; the caller keeps `pixels` alive.
+static cv::Mat vueTrame(const EnteteTrame& t, const uint8_t* pixels) {
+    return cv::Mat((int)t.height, (int)t.width, t.channels == 3 ? CV_8UC3 : CV_8UC1,
+                   const_cast<uint8_t*>(pixels), (size_t)t.stride);
+}
 
-    int x0 = clampInt(px - radius, 0, A.w - 1);
-    int x1 = clampInt(px + radius, 0, A.w - 1);
-    int y0 = clampInt(py - radius, 0, A.h - 1);
-    int y1 = clampInt(py + radius, 0, A.h - 1);
+static bool lireTrameStdin(std::vector<uint8_t>& pixels, cv::Mat& out) {
+    EnteteTrame t;
+    if (std::fread(&t, sizeof(t), 1, stdin) != 1) return false;
+    if (!trameValide(t)) return false;
+    pixels.resize(tailleTrame(t));
+    if (std::fread(pixels.data(), 1, pixels.size(), stdin) != pixels.size()) return false;
+    out = vueTrame(t, pixels.data());
+    return true;
+}
 
-    double sum = 0.0;
-    double sx = 0.0, sy = 0.0;
+// -------------------- timings (--timings) --------------------
+// One JSON object per frame on stderr, so the stdout format parsed by vision_backend.py is untouched.
+using Horloge = std::chrono::steady_clock;
 
-    for (int y = y0; y <= y1; ++y) {
-        for (int x = x0; x <= x1; ++x) {
-            double w = (double)A.at(y, x);
-            sum += w;
-            sx += w * (double)x;
-            sy += w * (double)y;
-        }
+static double microsDepuis(Horloge::time_point t0) {
+    return std::chrono::duration<double, std::micro>(Horloge::now() - t0).count();
+}
+
+static void ecrireJsonChaine(std::ostream& os, const std::string& s);
+
+static void ecrireMesures(const std::string& source, const MesuresDetection& m, double totalUs) {
+    static std::mutex mSortie;  // daemon and batch threads share stderr
+
+    uint64_t bords = 0, votes = 0, cellules = 0;
+    std::ostringstream os;
+    os << std::fixed;
+    os.precision(1);
+    os << "{\"timings\":{\"source\":";
+    ecrireJsonChaine(os, source);
+    os << ",\"simd\":\"" << sobelIsa() << "\",\"total_us\":" << totalUs << ",\"stages\":[";
+    for (size_t i = 0; i < m.etapes.size(); ++i) {
+        const MesureEtape& e = m.etapes[i];
+        os << (i ? "," : "") << "{\"stage\":\"" << e.etape << "\",\"target\":\"" << e.cible << "\"";
+        if (e.modele >= 0) os << ",\"model\":" << e.modele;
+        os << ",\"us\":" << e.us;
+        if (std::strcmp(e.etape, "voter") == 0) os << ",\"edges\":" << e.bords << ",\"votes\":" << e.votes;
+        if (e.cellules) os << ",\"cells\":" << e.cellules;
+        os << "}";
+        bords += e.bords;
+        votes += e.votes;
+        cellules += e.cellules;
     }
+    os << "],\"counters\":{\"edge_pixels\":" << bords << ",\"votes\":" << votes
+       << ",\"cells_scanned\":" << cellules << "}}}\n";
+
+    std::lock_guard<std::mutex> lk(mSortie);
+    std::cerr << os.str() << std::flush;
+}
 
-    if (sum <= 0.0) return PicBary{false, 0, 0, peak};
-    return PicBary{true, (float)(sx / sum), (float)(sy / sum), peak};
+static void noterImread(MesuresDetection& m, Horloge::time_point t0) {
+    MesureEtape e;
+    e.etape = "imread";
+    e.cible = "frame";
+    e.us = microsDepuis(t0);
+    m.etapes.push_back(e);
 }
 
-struct PicPoint {
-    int x = 0, y = 0;
-    float bx = 0.0f, by = 0.0f;
-    uint16_t v = 0;
+// -------------------- daemon mode (--serve) --------------------
+// Length-prefixed binary protocol over a unix stream socket, native (little-endian) layout.
+// A connection carries any number of request/response pairs, processed in order.
+//   request : EnteteRequete, then payloadLen bytes
+//     kind 1 : payload = image path (utf-8, no trailing NUL)
+//     kind 2 : payload = encoded image bytes (png/jpg/..., decoded with cv::imdecode)
+//     kind 3 : payload = EnteteTrame + raw 8-bit gray/BGR pixels (no codec)
+//   response: EnteteReponse, then payloadLen bytes (ResultatFil when status == 0, empty otherwise)
+static const uint32_t kMagicRequete = 0x31544847; // "GHT1"
+static const uint32_t kMagicReponse = 0x52544847; // "GHTR"
+static const uint32_t kPayloadMax   = 64u << 20;
+
+enum : uint32_t {
+    kRequeteChemin  = 1,
+    kRequeteEncodee = 2,
+    kRequeteTrame   = 3,
 };
 
-static std::vector<PicPoint> topKpicsAvecBary(
-    const AccuImage& A,
-    int k,
-    int nmsRadius,
-    int baryRadius,
-    uint16_t minVal
-) {
-    // naive: take all candidates above minVal, sort desc, apply NMS, compute barycenter
-    struct Cand { int x,y; uint16_t v; };
-    std::vector<Cand> cands;
-    cands.reserve(2048);
+enum : uint32_t {
+    kStatutOk              = 0,
+    kStatutRequeteInvalide = 1,
+    kStatutImageIllisible  = 2,
+};
 
-    for (int y = 0; y < A.h; ++y) {
-        for (int x = 0; x < A.w; ++x) {
-            uint16_t v = A.at(y, x);
-            if (v >= minVal) cands.push_back({x,y,v});
-        }
-    }
-    std::sort(cands.begin(), cands.end(), [](const Cand& a, const Cand& b){ return a.v > b.v; });
-
-    std::vector<PicPoint> out;
-    for (const auto& c : cands) {
-        bool tooClose = false;
-        for (const auto& p : out) {
-            int dx = c.x - p.x;
-            int dy = c.y - p.y;
-            if (dx*dx + dy*dy <= nmsRadius*nmsRadius) { tooClose = true; break; }
-        }
-        if (tooClose) continue;
-
-        // barycenter around (c.x,c.y)
-        int x0 = clampInt(c.x - baryRadius, 0, A.w - 1);
-        int x1 = clampInt(c.x + baryRadius, 0, A.w - 1);
-        int y0 = clampInt(c.y - baryRadius, 0, A.h - 1);
-        int y1 = clampInt(c.y + baryRadius, 0, A.h - 1);
-
-        double sum = 0.0, sx = 0.0, sy = 0.0;
-        for (int y = y0; y <= y1; ++y) {
-            for (int x = x0; x <= x1; ++x) {
-                double w = (double)A.at(y, x);
-                sum += w;
-                sx += w * (double)x;
-                sy += w * (double)y;
-            }
-        }
-        PicPoint pp;
-        pp.x = c.x; pp.y = c.y; pp.v = c.v;
-        if (sum > 0.0) { pp.bx = (float)(sx / sum); pp.by = (float)(sy / sum); }
-        else { pp.bx = (float)c.x; pp.by = (float)c.y; }
-        out.push_back(pp);
+enum : uint32_t {
+    kFlagEqHist  = 1u << 0,
+    kFlagClahe   = 1u << 1,
+    kFlagAutoThr = 1u << 2,
+};
 
-        if ((int)out.size() >= k) break;
-    }
-    return out;
-}
+#pragma pack(push, 1)
+struct EnteteRequete {
+    uint32_t magic;
+    uint32_t kind;
+    uint32_t flags;          // kFlag*
+    int32_t  blurK;
+    int32_t  faceEdge;       // -1 = default / auto
+    int32_t  eyeEdge;        // -1 = default / auto
+    int32_t  faceMinScore;   // -1 = default
+    int32_t  eyeMinPeak;     // -1 = default
+    uint32_t payloadLen;
+};
 
-// pair selection
-static bool choisirPaireYeux(
-    const std::vector<PicPoint>& pics,
-    int faceCxInZone,
-    int faceCyInZone,
-    int minDx, int maxDx,
-    int maxDy,
-    PicPoint& oeilGauche,
-    PicPoint& oeilDroit
-) {
-    bool found = false;
-    uint32_t best = 0;
-
-    for (size_t i = 0; i < pics.size(); ++i) {
-        for (size_t j = i + 1; j < pics.size(); ++j) {
-            const auto& p1 = pics[i];
-            const auto& p2 = pics[j];
-
-            // order left-right
-            const auto& L = (p1.bx <= p2.bx) ? p1 : p2;
-            const auto& R = (p1.bx <= p2.bx) ? p2 : p1;
-
-            int dx = (int)std::lround(R.bx - L.bx);
-            int dy = (int)std::lround(std::fabs(R.by - L.by));
-
-            if (dx < minDx || dx > maxDx) continue;
-            if (dy > maxDy) continue;
-
-            // keep roughly above face center
-            if ((int)std::lround(L.by) > faceCyInZone) continue;
-            if ((int)std::lround(R.by) > faceCyInZone) continue;
-
-            uint32_t score = (uint32_t)L.v + (uint32_t)R.v;
-            if (!found || score > best) {
-                found = true;
-                best = score;
-                oeilGauche = L;
-                oeilDroit = R;
-            }
-        }
-    }
-    return found;
-}
+struct EnteteReponse {
+    uint32_t magic;
+    uint32_t status;
+    uint32_t payloadLen;
+};
+
+struct ResultatFil {
+    int32_t faceOk, faceX, faceY, faceRx, faceRy;
+    int32_t eyesOk, ex1, ey1, ex2, ey2, eyeR;
+    int32_t edgeFace, edgeEye, faceMinScore, eyeMinPeak;
+};
+#pragma pack(pop)
+
+static volatile sig_atomic_t gArret = 0;
 
-// -------------------- templates --------------------
-static grayImage templateEllipse(int w, int h, float rx, float ry) {
-    grayImage img = makeGris(w, h, 255);
-    int cx = w / 2;
-    int cy = h / 2;
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
-            float dx = (float)(x - cx);
-            float dy = (float)(y - cy);
-            float v = (dx*dx)/(rx*rx) + (dy*dy)/(ry*ry);
-            if (std::fabs(v - 1.0f) < 0.03f) img.at(y, x) = 0;
+static void surSignalArret(int) { gArret = 1; }
+
+static bool lireTout(int fd, void* buf, size_t n) {
+    uint8_t* p = (uint8_t*)buf;
+    while (n > 0) {
+        ssize_t k = ::read(fd, p, n);
+        if (k < 0 && errno == EINTR) {
+            if (gArret) return false;
+            continue;
         }
+        if (k <= 0) return false;
+        p += k;
+        n -= (size_t)k;
     }
-    return img;
+    return true;
 }
 
-static grayImage templateCercle(int w, int h, float r) {
-    grayImage img = makeGris(w, h, 255);
-    int cx = w / 2;
-    int cy = h / 2;
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
-            float dx = (float)(x - cx);
-            float dy = (float)(y - cy);
-            float d = std::sqrt(dx*dx + dy*dy);
-            if (std::fabs(d - r) < 2.5f) img.at(y, x) = 0;
-        }
+static bool ecrireTout(int fd, const void* buf, size_t n) {
+    const uint8_t* p = (const uint8_t*)buf;
+    while (n > 0) {
+        ssize_t k = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        p += k;
+        n -= (size_t)k;
     }
-    return img;
+    return true;
 }
 
-static RTable construireRTableDepuisTemplate(const grayImage& templ, uint16_t minMag, uint16_t maxMag) {
-    ChampGradient g = sobel(templ);
+// Process-wide state shared by every request of --serve / --shm.
+struct Service {
+    const BanqueModeles& banque;
+    OptionsMoteur moteur;   // engine knobs come from the command line, not from requests
+    bool timings = false;
+};
 
-    // template center
-    int cx = templ.w / 2;
-    int cy = templ.h / 2;
+static OptionsDetection optionsDepuisRequete(const EnteteRequete& req, const Service& svc) {
+    OptionsDetection opt;
+    opt.moteur = svc.moteur;
+    opt.useEqHist = (req.flags & kFlagEqHist) != 0;
+    opt.useClahe = (req.flags & kFlagClahe) != 0;
+    opt.autoThr = (req.flags & kFlagAutoThr) != 0;
+    opt.blurK = req.blurK;
+    opt.faceEdgeUser = req.faceEdge;
+    opt.eyeEdgeUser = req.eyeEdge;
+    opt.faceMinUser = req.faceMinScore;
+    opt.eyeMinUser = req.eyeMinPeak;
+    return opt;
+}
 
-    RTable rt;
+static bool envoyerReponse(int fd, uint32_t status, const ResultatFil* res) {
+    EnteteReponse rep;
+    rep.magic = kMagicReponse;
+    rep.status = status;
+    rep.payloadLen = res ? (uint32_t)sizeof(ResultatFil) : 0u;
+    if (!ecrireTout(fd, &rep, sizeof(rep))) return false;
+    return !res || ecrireTout(fd, res, sizeof(ResultatFil));
+}
 
-    for (int y = 0; y < templ.h; ++y) {
-        for (int x = 0; x < templ.w; ++x) {
-            uint16_t mag = g.m(y, x);
-            if (mag < minMag || mag > maxMag) continue;
-            uint16_t ang = g.a(y, x);
+static ResultatFil versResultatFil(const faceeyes& r, const Seuils& s) {
+    ResultatFil res;
+    res.faceOk = r.faceOk ? 1 : 0;
+    res.faceX = r.faceX; res.faceY = r.faceY;
+    res.faceRx = r.faceRx; res.faceRy = r.faceRy;
+    res.eyesOk = r.eyesOk ? 1 : 0;
+    res.ex1 = r.ex1; res.ey1 = r.ey1;
+    res.ex2 = r.ex2; res.ey2 = r.ey2;
+    res.eyeR = r.eyeR;
+    res.edgeFace = s.edgeFace; res.edgeEye = s.edgeEye;
+    res.faceMinScore = s.faceMinScore; res.eyeMinPeak = s.eyeMinPeak;
+    return res;
+}
 
-            int dx = cx - x;
-            int dy = cy - y;
-            rt.lut[(size_t)ang].push_back({(int16_t)dx, (int16_t)dy});
+static void servirConnexion(int fd, const Service& svc) {
+    std::vector<uint8_t> payload;
+    EspaceTravail ws;   // buffers reused by every request of the connection
+    for (;;) {
+        EnteteRequete req;
+        if (!lireTout(fd, &req, sizeof(req))) return;
+        if (req.magic != kMagicRequete || req.payloadLen > kPayloadMax) {
+            // stream is out of sync, nothing sensible to do but drop the connection
+            envoyerReponse(fd, kStatutRequeteInvalide, nullptr);
+            return;
+        }
+        payload.resize(req.payloadLen);
+        if (req.payloadLen > 0 && !lireTout(fd, payload.data(), payload.size())) return;
+
+        MesuresDetection mesures;
+        Horloge::time_point t0 = Horloge::now();
+        cv::Mat src;
+        if (req.kind == kRequeteChemin) {
+            src = cv::imread(std::string(payload.begin(), payload.end()));
+        } else if (req.kind == kRequeteEncodee) {
+            src = cv::imdecode(payload, cv::IMREAD_COLOR);
+        } else if (req.kind == kRequeteTrame) {
+            EnteteTrame t;
+            if (payload.size() < sizeof(t)) {
+                if (!envoyerReponse(fd, kStatutRequeteInvalide, nullptr)) return;
+                continue;
+            }
+            std::memcpy(&t, payload.data(), sizeof(t));
+            if (!trameValide(t) || payload.size() - sizeof(t) < tailleTrame(t)) {
+                if (!envoyerReponse(fd, kStatutImageIllisible, nullptr)) return;
+                continue;
+            }
+            src = vueTrame(t, payload.data() + sizeof(t));
+        } else {
+            if (!envoyerReponse(fd, kStatutRequeteInvalide, nullptr)) return;
+            continue;
+        }
+        if (src.empty() || (src.channels() != 3 && src.channels() != 1) || !tailleImageValide(src.cols, src.rows)) {
+            if (!envoyerReponse(fd, kStatutImageIllisible, nullptr)) return;
+            continue;
         }
-    }
-    return rt;
-}
 
-// -------------------- models --------------------
-struct facemodel { int rx = 0, ry = 0; RTable lut; };
-struct eyemodel  { int r = 0; RTable lut; };
+        if (svc.timings) noterImread(mesures, t0);
 
-// -------------------- adaptive threshold helper --------------------
-static uint16_t magPercentile(const ChampGradient& cg, double q /*0..1*/) {
-    // sample to reduce cost
-    std::vector<uint16_t> s;
-    s.reserve((size_t)(cg.w * cg.h / 4));
-    for (int y = 0; y < cg.h; y += 2) {
-        for (int x = 0; x < cg.w; x += 2) {
-            s.push_back(cg.m(y, x));
+        OptionsDetection opt = optionsDepuisRequete(req, svc);
+        Seuils seuils;
+        faceeyes r = analyser(src, svc.banque, opt, seuils, nullptr, false, svc.timings ? &mesures : nullptr, &ws);
+        if (svc.timings) {
+            static const char* const kSources[] = {"?", "path", "encoded", "frame"};
+            ecrireMesures(kSources[req.kind], mesures, microsDepuis(t0));
         }
+        ResultatFil res = versResultatFil(r, seuils);
+        if (!envoyerReponse(fd, kStatutOk, &res)) return;
     }
-    if (s.empty()) return 0;
-
-    size_t idx = (size_t)std::lround(q * (double)(s.size() - 1));
-    idx = std::min(idx, s.size() - 1);
-
-    std::nth_element(s.begin(), s.begin() + idx, s.end());
-    return s[idx];
 }
 
-struct faceeyes {
-    bool faceOk = false;
-    int faceX = 0, faceY = 0;
-    int faceRx = 0, faceRy = 0;
-
-    int eyeRoiX = 0, eyeRoiY = 0, eyeRoiW = 0, eyeRoiH = 0;
-
-    bool eyesOk = false;
-    int ex1 = 0, ey1 = 0, ex2 = 0, ey2 = 0;
-    int eyeR = 0;
+// Clients served at once; further connections are closed until one ends.
+static const size_t kConnexionsMax = 64;
 
-    // debug
-    ChampGradient dbgGrads;
-    bool dbgFaceAccuOk = false;
-    AccuImage dbgFaceAccu;
-    bool dbgEyeAccuOk = false;
-    AccuImage dbgEyeAccu;
+// One client thread. The fd is closed by the accept loop once the thread is joined, so
+// shutdown() never hits a reused descriptor.
+struct Connexion {
+    int fd = -1;
+    std::thread t;
+    std::atomic<bool> finie{false};
 };
 
-static faceeyes detectfaceeyes(
-    const grayImage& img,
-    const std::vector<facemodel>& faceModels,
-    const std::vector<eyemodel>& eyeModels,
-    uint16_t seuilFace, uint16_t seuilEye,
-    uint16_t faceMinScore, uint16_t eyeMinPeak
-) {
-    faceeyes out;
-    out.dbgGrads = sobel(img);
+static int servir(const std::string& chemin, const Service& svc) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (chemin.empty() || chemin.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Erreur: chemin de socket invalide: " << chemin << "\n";
+        return 2;
+    }
+    std::memcpy(addr.sun_path, chemin.c_str(), chemin.size() + 1);
 
-    // FACE: pick best model by peak (barycentered max)
-    uint16_t bestFacePeak = 0;
-    int bestFaceX = 0, bestFaceY = 0;
-    int bestRx = 0, bestRy = 0;
-    AccuImage bestAccu = makeAccu(img.w, img.h);
+    int srv = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (srv < 0) {
+        std::cerr << "Erreur: socket(): " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    ::unlink(chemin.c_str());
+    if (::bind(srv, (const sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(srv, 16) < 0) {
+        std::cerr << "Erreur: bind/listen " << chemin << ": " << std::strerror(errno) << "\n";
+        ::close(srv);
+        return 1;
+    }
 
-    for (const auto& fm : faceModels) {
-        AccuImage A = makeAccu(img.w, img.h);
-        voter(A, img, out.dbgGrads, fm.lut, seuilFace);
+    // no SA_RESTART: a signal must interrupt accept()/read() so the loop can exit
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = surSignalArret;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    std::cerr << "[serve] listening on " << chemin
+              << " (" << svc.banque.faces.size() << " face models, "
+              << svc.banque.yeux.size() << " eye models)\n";
+
+    // Connection threads keep SIGINT/SIGTERM blocked so the accept loop is the one interrupted.
+    sigset_t arret, ancien;
+    sigemptyset(&arret);
+    sigaddset(&arret, SIGINT);
+    sigaddset(&arret, SIGTERM);
+
+    std::vector<std::unique_ptr<Connexion>> connexions;
+    auto reprendreFinies = [&]() {
+        for (size_t i = 0; i < connexions.size();) {
+            if (!connexions[i]->finie.load(std::memory_order_acquire)) { ++i; continue; }
+            connexions[i]->t.join();
+            ::close(connexions[i]->fd);
+            connexions[i] = std::move(connexions.back());
+            connexions.pop_back();
+        }
+    };
 
-        PicBary b = barycentreLocalAutourMax(A, 6);
-        if (b.ok && b.peak >= bestFacePeak) {
-            bestFacePeak = b.peak;
-            bestFaceX = (int)std::lround(b.bx);
-            bestFaceY = (int)std::lround(b.by);
-            bestRx = fm.rx;
-            bestRy = fm.ry;
-            bestAccu = A;
+    while (!gArret) {
+        int c = ::accept(srv, nullptr, nullptr);
+        if (c < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Erreur: accept(): " << std::strerror(errno) << "\n";
+            break;
         }
+        reprendreFinies();
+        if (connexions.size() >= kConnexionsMax) {
+            std::cerr << "[serve] " << kConnexionsMax << " clients already connected, connection refused\n";
+            ::close(c);
+            continue;
+        }
+        // the bank is read-only once built: one thread per client, no locking needed
+        std::unique_ptr<Connexion> cx(new Connexion());
+        cx->fd = c;
+        Connexion* brut = cx.get();
+        pthread_sigmask(SIG_BLOCK, &arret, &ancien);
+        cx->t = std::thread([brut, &svc]() {
+            servirConnexion(brut->fd, svc);
+            brut->finie.store(true, std::memory_order_release);
+        });
+        pthread_sigmask(SIG_SETMASK, &ancien, nullptr);
+        connexions.push_back(std::move(cx));
     }
 
-    out.dbgFaceAccuOk = true;
-    out.dbgFaceAccu = bestAccu;
-
-    if (bestFacePeak < faceMinScore) {
-        out.faceOk = false;
-        return out;
+    // svc, the bank and the pool belong to main: wake every client and wait for it (a
+    // detection in progress finishes first)
+    for (auto& cx : connexions) ::shutdown(cx->fd, SHUT_RDWR);
+    for (auto& cx : connexions) {
+        cx->t.join();
+        ::close(cx->fd);
     }
 
-    out.faceOk = true;
-    out.faceX = bestFaceX;
-    out.faceY = bestFaceY;
-    out.faceRx = bestRx;
-    out.faceRy = bestRy;
-
-    // EYES: ROI above face center (tighten to reduce window edges)
-    int zx0 = clampInt(bestFaceX - (int)std::lround(bestRx * 1.2), 0, img.w - 1);
-    int zx1 = clampInt(bestFaceX + (int)std::lround(bestRx * 1.2), 0, img.w - 1);
-    int zy0 = clampInt(bestFaceY - (int)std::lround(bestRy * 1.1), 0, img.h - 1);
-    int zy1 = clampInt(bestFaceY - (int)std::lround(bestRy * 0.15), 0, img.h - 1);
-
-    if (zx1 <= zx0 || zy1 <= zy0) {
-        out.eyesOk = false;
-        return out;
-    }
+    ::close(srv);
+    ::unlink(chemin.c_str());
+    return 0;
+}
 
-    out.eyeRoiX = zx0;
-    out.eyeRoiY = zy0;
-    out.eyeRoiW = (zx1 - zx0 + 1);
-    out.eyeRoiH = (zy1 - zy0 + 1);
+// -------------------- shared-memory ring (--shm) --------------------
+// POSIX shared-memory segment (/dev/shm/<name>) created by the detector:
+//   EnteteAnneau | nSlots x (EnteteSlot + pixels) | nSlots x Completion
+// Slot life cycle: FREE -(producer writes frame)-> READY -(detector)-> BUSY -> DONE
+// -(producer reads its completion)-> FREE. Pixels are processed in place, the
+// result goes to the completion queue (cqHead = completions published so far);
+// a slot is DONE before its completion is published, so the producer's FREE is
+// always the last store to it.
+// At most nSlots frames are in flight, so a queue of nSlots entries never
+// overwrites an unread completion. Shared words are accessed with __atomic builtins.
+static const uint32_t kMagicAnneau   = 0x53544847; // "GHTS"
+static const uint32_t kVersionAnneau = 1;
+
+enum : uint32_t {
+    kSlotLibre   = 0,
+    kSlotPret    = 1,
+    kSlotEnCours = 2,
+    kSlotFini    = 3,
+};
 
-    // Build sub-image zoneYeux
-    grayImage zoneYeux;
-    zoneYeux.w = out.eyeRoiW;
-    zoneYeux.h = out.eyeRoiH;
-    zoneYeux.p.assign((size_t)zoneYeux.w * (size_t)zoneYeux.h, 0);
-    for (int y = 0; y < zoneYeux.h; ++y) {
-        for (int x = 0; x < zoneYeux.w; ++x) {
-            zoneYeux.at(y, x) = img.at(zy0 + y, zx0 + x);
-        }
-    }
+#pragma pack(push, 1)
+struct EnteteAnneau {
+    uint32_t magic;        // written last, once the segment is initialised
+    uint32_t version;
+    uint32_t nSlots;
+    uint32_t slotBytes;    // pixel capacity of one slot
+    uint32_t slotsOffset;  // first EnteteSlot
+    uint32_t slotStride;   // bytes from one EnteteSlot to the next
+    uint32_t cqOffset;     // first Completion
+    uint32_t cqHead;       // completions published (detector increments)
+    uint32_t serverPid;
+    uint8_t  pad[28];
+};
 
-    ChampGradient gradsYeux = sobel(zoneYeux);
+struct EnteteSlot {
+    uint32_t state;        // kSlot*
+    uint32_t seq;          // producer tag, echoed in the completion
+    EnteteTrame trame;     // pixels follow this header
+    uint32_t flags;        // same meaning as EnteteRequete
+    int32_t  blurK;
+    int32_t  faceEdge;
+    int32_t  eyeEdge;
+    int32_t  faceMinScore;
+    int32_t  eyeMinPeak;
+    uint8_t  pad[16];
+};
 
-    // for each radius model, pick best peaks list, keep global best
-    uint16_t bestEyePeak = 0;
-    int bestR = 0;
-    AccuImage bestEyeAccu = makeAccu(zoneYeux.w, zoneYeux.h);
-    std::vector<PicPoint> bestPics;
+struct Completion {
+    uint32_t seq;
+    uint32_t slot;
+    uint32_t status;       // kStatut*
+    ResultatFil res;
+};
+#pragma pack(pop)
 
-    for (const auto& em : eyeModels) {
-        AccuImage A = makeAccu(zoneYeux.w, zoneYeux.h);
-        voter(A, zoneYeux, gradsYeux, em.lut, seuilEye);
+static_assert(sizeof(EnteteAnneau) == 64, "EnteteAnneau layout");
+static_assert(sizeof(EnteteSlot) == 64, "EnteteSlot layout");
 
-        auto pics = topKpicsAvecBary(A, /*k*/6, /*nmsRadius*/em.r * 2, /*baryRadius*/6, /*minVal*/eyeMinPeak);
-        if (pics.empty()) continue;
+static size_t alignerSur64(size_t n) { return (n + 63) & ~(size_t)63; }
 
-        uint16_t localPeak = 0;
-        for (auto& p : pics) localPeak = std::max<uint16_t>(localPeak, p.v);
+static EnteteSlot* slotAnneau(uint8_t* base, const EnteteAnneau* h, uint32_t i) {
+    return (EnteteSlot*)(base + h->slotsOffset + (size_t)i * h->slotStride);
+}
 
-        if (localPeak >= bestEyePeak) {
-            bestEyePeak = localPeak;
-            bestR = em.r;
-            bestEyeAccu = A;
-            bestPics = pics;
-        }
+static void traiterSlot(uint8_t* base, EnteteAnneau* h, uint32_t i, const Service& svc, EspaceTravail& ws) {
+    EnteteSlot* slot = slotAnneau(base, h, i);
+
+    Completion c;
+    std::memset(&c, 0, sizeof(c));
+    c.seq = slot->seq;
+    c.slot = i;
+    c.status = kStatutImageIllisible;
+
+    const EnteteTrame t = slot->trame;
+    if (trameValide(t) && tailleTrame(t) <= h->slotBytes) {
+        EnteteRequete req;
+        std::memset(&req, 0, sizeof(req));
+        req.flags = slot->flags;
+        req.blurK = slot->blurK;
+        req.faceEdge = slot->faceEdge;
+        req.eyeEdge = slot->eyeEdge;
+        req.faceMinScore = slot->faceMinScore;
+        req.eyeMinPeak = slot->eyeMinPeak;
+
+        // the slot belongs to us until DONE: preprocessing may overwrite it
+        MesuresDetection mesures;
+        Horloge::time_point t0 = Horloge::now();
+        cv::Mat src = vueTrame(t, (const uint8_t*)(slot + 1));
+        Seuils seuils;
+        faceeyes r = analyser(src, svc.banque, optionsDepuisRequete(req, svc), seuils, nullptr, /*enPlace*/true,
+                              svc.timings ? &mesures : nullptr, &ws);
+        if (svc.timings) ecrireMesures("shm", mesures, microsDepuis(t0));
+        c.res = versResultatFil(r, seuils);
+        c.status = kStatutOk;
     }
 
-    out.dbgEyeAccuOk = true;
-    out.dbgEyeAccu = bestEyeAccu;
+    uint32_t head = __atomic_load_n(&h->cqHead, __ATOMIC_RELAXED);
+    Completion* cq = (Completion*)(base + h->cqOffset);
+    std::memcpy(&cq[head % h->nSlots], &c, sizeof(c));
+    __atomic_store_n(&slot->state, (uint32_t)kSlotFini, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->cqHead, head + 1, __ATOMIC_RELEASE);
+}
 
-    if (bestPics.empty()) {
-        out.eyesOk = false;
-        return out;
+static int servirAnneau(const std::string& nom, uint32_t nSlots, int maxW, int maxH, const Service& svc) {
+    nSlots = std::max<uint32_t>(1, std::min<uint32_t>(nSlots, 256));
+    const size_t slotBytes = alignerSur64((size_t)std::max(1, maxW) * (size_t)std::max(1, maxH) * 3);
+    const size_t slotStride = sizeof(EnteteSlot) + slotBytes;
+    const size_t slotsOffset = sizeof(EnteteAnneau);
+    const size_t cqOffset = slotsOffset + (size_t)nSlots * slotStride;
+    const size_t total = cqOffset + alignerSur64((size_t)nSlots * sizeof(Completion));
+    if (total > 0xffffffffu) {
+        std::cerr << "Erreur: segment partage trop grand\n";
+        return 2;
     }
 
-    // pair selection constraints based on face size
-    PicPoint og, od;
-    int minDx = std::max(10, (int)std::lround(bestRx * 0.55));
-    int maxDx = std::max(minDx + 10, (int)std::lround(bestRx * 1.60));
-    int maxDy = std::max(10, (int)std::lround(bestRy * 0.30));
-
-    bool pairOk = choisirPaireYeux(bestPics, bestFaceX - zx0, bestFaceY - zy0, minDx, maxDx, maxDy, og, od);
-    if (!pairOk) {
-        out.eyesOk = false;
-        return out;
+    // always a fresh segment: a leftover one (crashed detector) may still be mapped by a
+    // producer, which keeps its own copy once the name is unlinked
+    const std::string shmNom = (!nom.empty() && nom[0] == '/') ? nom : "/" + nom;
+    ::shm_unlink(shmNom.c_str());
+    int fd = ::shm_open(shmNom.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        std::cerr << "Erreur: shm_open " << shmNom << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    if (::ftruncate(fd, (off_t)total) < 0) {
+        std::cerr << "Erreur: ftruncate: " << std::strerror(errno) << "\n";
+        ::close(fd);
+        ::shm_unlink(shmNom.c_str());
+        return 1;
+    }
+    void* m = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {
+        std::cerr << "Erreur: mmap: " << std::strerror(errno) << "\n";
+        ::shm_unlink(shmNom.c_str());
+        return 1;
     }
 
-    out.eyesOk = true;
-    out.eyeR = bestR;
+    uint8_t* base = (uint8_t*)m;   // zero-filled by ftruncate
+    EnteteAnneau* h = (EnteteAnneau*)base;
+    h->version = kVersionAnneau;
+    h->nSlots = nSlots;
+    h->slotBytes = (uint32_t)slotBytes;
+    h->slotsOffset = (uint32_t)slotsOffset;
+    h->slotStride = (uint32_t)slotStride;
+    h->cqOffset = (uint32_t)cqOffset;
+    h->serverPid = (uint32_t)::getpid();
+    __atomic_store_n(&h->magic, kMagicAnneau, __ATOMIC_RELEASE);
+
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = surSignalArret;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    std::cerr << "[shm] ring /dev/shm" << shmNom << " slots=" << nSlots
+              << " slotBytes=" << slotBytes << "\n";
+
+    // Poll the slots; back off to short sleeps while idle.
+    EspaceTravail ws;
+    int inactif = 0;
+    while (!gArret) {
+        bool travail = false;
+        for (uint32_t i = 0; i < nSlots; ++i) {
+            EnteteSlot* slot = slotAnneau(base, h, i);
+            uint32_t attendu = kSlotPret;
+            if (!__atomic_compare_exchange_n(&slot->state, &attendu, (uint32_t)kSlotEnCours,
+                                             false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                continue;
+            }
+            traiterSlot(base, h, i, svc, ws);
+            travail = true;
+        }
+        if (travail) {
+            inactif = 0;
+        } else if (++inactif > 1000) {
+            ::usleep(200);
+        } else {
+            std::this_thread::yield();
+        }
+    }
 
-    out.ex1 = zx0 + (int)std::lround(og.bx);
-    out.ey1 = zy0 + (int)std::lround(og.by);
-    out.ex2 = zx0 + (int)std::lround(od.bx);
-    out.ey2 = zy0 + (int)std::lround(od.by);
+    ::munmap(m, total);
+    ::shm_unlink(shmNom.c_str());
+    return 0;
+}
 
-    return out;
+// -------------------- batch mode (--batch) --------------------
+// One process, one model bank, a worker pool over the image list. Each image yields
+// one NDJSON line on stdout, written as soon as it is done (completion order).
+static bool extensionImage(const std::filesystem::path& p) {
+    std::string e = p.extension().string();
+    for (char& c : e) c = (char)std::tolower((unsigned char)c);
+    static const char* const kExt[] = {".png", ".jpg", ".jpeg", ".bmp", ".ppm", ".pgm", ".pnm",
+                                       ".tif", ".tiff", ".webp"};
+    for (const char* k : kExt) if (e == k) return true;
+    return false;
 }
 
-static cv::Mat toMatAccu8(const AccuImage& A) {
-    cv::Mat m(A.h, A.w, CV_8UC1);
-    uint16_t maxv = 1;
-    for (int y = 0; y < A.h; ++y)
-        for (int x = 0; x < A.w; ++x)
-            maxv = std::max<uint16_t>(maxv, A.at(y, x));
+// Directory: its image files (non-recursive, sorted). File: one path per line ('#' comments).
+static bool listerBatch(const std::string& source, std::vector<std::string>& chemins) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (fs::is_directory(source, ec)) {
+        for (const auto& e : fs::directory_iterator(source, ec)) {
+            if (e.is_regular_file(ec) && extensionImage(e.path())) chemins.push_back(e.path().string());
+        }
+        if (ec) return false;
+        std::sort(chemins.begin(), chemins.end());
+        return true;
+    }
+    std::ifstream in(source);
+    if (!in) return false;
+    std::string ligne;
+    while (std::getline(in, ligne)) {
+        while (!ligne.empty() && (ligne.back() == '\r' || ligne.back() == ' ' || ligne.back() == '\t')) ligne.pop_back();
+        size_t d = ligne.find_first_not_of(" \t");
+        if (d == std::string::npos || ligne[d] == '#') continue;
+        chemins.push_back(ligne.substr(d));
+    }
+    return true;
+}
 
-    for (int y = 0; y < A.h; ++y) {
-        uint8_t* row = m.ptr<uint8_t>(y);
-        for (int x = 0; x < A.w; ++x) {
-            float f = (float)A.at(y, x) / (float)maxv;
-            row[x] = (uint8_t)clampInt((int)std::lround(255.0f * f), 0, 255);
+static void ecrireJsonChaine(std::ostream& os, const std::string& s) {
+    os << '"';
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << (char)c;
+        } else if (c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            os << buf;
+        } else {
+            os << (char)c;
         }
     }
-    return m;
+    os << '"';
 }
 
-static void drawOverlay(cv::Mat& frame, const faceeyes& r) {
-    if (r.faceOk) {
-        cv::circle(frame, cv::Point(r.faceX, r.faceY), 6, cv::Scalar(0, 255, 0), 2);
+static std::string ligneBatch(const std::string& chemin, bool lu, const faceeyes& r, const Seuils& s) {
+    std::ostringstream os;
+    os << "{\"path\":";
+    ecrireJsonChaine(os, chemin);
+    if (!lu) {
+        os << ",\"ok\":false,\"error\":\"unreadable\"}\n";
+        return os.str();
     }
-    if (r.eyeRoiW > 0 && r.eyeRoiH > 0) {
-        cv::rectangle(frame, cv::Rect(r.eyeRoiX, r.eyeRoiY, r.eyeRoiW, r.eyeRoiH), cv::Scalar(255, 0, 0), 2);
+    os << ",\"ok\":true,\"face\":";
+    if (r.faceOk) {
+        os << "{\"x\":" << r.faceX << ",\"y\":" << r.faceY << ",\"rx\":" << r.faceRx << ",\"ry\":" << r.faceRy << "}";
+    } else {
+        os << "null";
     }
+    os << ",\"eyes\":";
     if (r.eyesOk) {
-        cv::circle(frame, cv::Point(r.ex1, r.ey1), r.eyeR, cv::Scalar(0, 255, 255), 2);
-        cv::circle(frame, cv::Point(r.ex2, r.ey2), r.eyeR, cv::Scalar(0, 255, 255), 2);
+        os << "[{\"x\":" << r.ex1 << ",\"y\":" << r.ey1 << "},{\"x\":" << r.ex2 << ",\"y\":" << r.ey2
+           << "}],\"eye_r\":" << r.eyeR;
+    } else {
+        os << "null";
     }
+    os << ",\"edge_face\":" << s.edgeFace << ",\"edge_eye\":" << s.edgeEye
+       << ",\"face_min_score\":" << s.faceMinScore << ",\"eye_min_peak\":" << s.eyeMinPeak << "}\n";
+    return os.str();
+}
+
+static int traiterBatch(const std::string& source, const BanqueModeles& banque,
+                        const OptionsDetection& opt, bool timings) {
+    std::vector<std::string> chemins;
+    if (!listerBatch(source, chemins)) {
+        std::cerr << "Erreur: impossible de lire la liste batch: " << source << "\n";
+        return 1;
+    }
+
+    std::mutex mSortie;
+    std::atomic<int> illisibles{0};
+    // Workspaces handed out per image from a free list; a waiting thread only helps with
+    // its own image's votes, so there are at most as many as images in flight (threads).
+    std::mutex mEspaces;
+    std::vector<std::unique_ptr<EspaceTravail>> espaces;
+    const std::function<void(size_t)> tache = [&](size_t i) {
+        MesuresDetection mesures;
+        Horloge::time_point t0 = Horloge::now();
+        cv::Mat src = cv::imread(chemins[i]);
+        if (timings) noterImread(mesures, t0);
+        faceeyes r;
+        Seuils seuils;
+        const bool lu = !src.empty() && src.channels() == 3 && tailleImageValide(src.cols, src.rows);
+        if (lu) {
+            std::unique_ptr<EspaceTravail> ws;
+            {
+                std::lock_guard<std::mutex> lk(mEspaces);
+                if (!espaces.empty()) {
+                    ws = std::move(espaces.back());
+                    espaces.pop_back();
+                }
+            }
+            if (!ws) ws.reset(new EspaceTravail());
+            r = analyser(src, banque, opt, seuils, nullptr, false, timings ? &mesures : nullptr, ws.get());
+            {
+                std::lock_guard<std::mutex> lk(mEspaces);
+                espaces.push_back(std::move(ws));
+            }
+            if (timings) ecrireMesures(chemins[i], mesures, microsDepuis(t0));
+        } else {
+            illisibles.fetch_add(1, std::memory_order_relaxed);
+        }
+        const std::string ligne = ligneBatch(chemins[i], lu, r, seuils);
+        std::lock_guard<std::mutex> lk(mSortie);
+        std::cout << ligne << std::flush;
+    };
+
+    // images and, nested inside each detection, face/eye models share the engine pool
+    PoolTaches* pool = opt.moteur.pool;
+    if (pool) {
+        pool->executerParallele(chemins.size(), tache);
+    } else {
+        for (size_t i = 0; i < chemins.size(); ++i) tache(i);
+    }
+
+    std::cerr << "[DBG] batch images=" << chemins.size() << " unreadable=" << illisibles.load()
+              << " threads=" << (pool ? pool->taille() + 1 : 1) << "\n";
+    return 0;
 }
 
 int main(int argc, char** argv) {
     bool doImage = false;
     std::string imagePath;
+    bool rawStdin = false;
+    std::string servePath;
+    std::string shmName;
+    int shmSlots = 4;
+    int shmMaxW = 1920, shmMaxH = 1080;
+    std::string batchSource;
+    int nThreads = 0;
+    int nEchellesFace = 0;
+    bool timings = false;
 
     // GUI controls (kept compatible with your current code)
     bool imageGui = false;
     bool guiSteps = false;
     int guiDelayMs = 0;
 
-    // New options
-    bool useEqHist = true;
-    bool useClahe = false;
-    int blurK = 5;               // odd, 0 disables
-    bool autoThr = true;
-    int faceEdgeUser = -1;
-    int eyeEdgeUser  = -1;
-    int faceMinUser  = -1;
-    int eyeMinUser   = -1;
+    OptionsDetection opt;
 
     for (int i = 1; i < argc; ++i) {
         std::string a = argv[i];
@@ -632,6 +847,80 @@ int main(int argc, char** argv) {
             if (i + 1 < argc) { doImage = true; imagePath = argv[i + 1]; i++; }
             continue;
         }
+        if (a == "--raw-stdin") { rawStdin = true; continue; }
+        if (a == "--serve") {
+            if (i + 1 < argc) { servePath = argv[i + 1]; i++; }
+            continue;
+        }
+        if (a == "--shm") {
+            if (i + 1 < argc) { shmName = argv[i + 1]; i++; }
+            continue;
+        }
+        if (a == "--shm-slots") {
+            if (i + 1 < argc) { shmSlots = std::atoi(argv[i + 1]); i++; }
+            continue;
+        }
+        if (a == "--shm-max-size") {
+            if (i + 1 < argc) {
+                if (std::sscanf(argv[i + 1], "%dx%d", &shmMaxW, &shmMaxH) != 2) { shmMaxW = 1920; shmMaxH = 1080; }
+                i++;
+            }
+            continue;
+        }
+
+        if (a == "--batch") {
+            if (i + 1 < argc) { batchSource = argv[i + 1]; i++; }
+            continue;
+        }
+        if (a == "--threads") {
+            if (i + 1 < argc) { nThreads = std::atoi(argv[i + 1]); i++; }
+            continue;
+        }
+
+        if (a == "--vote-tiles") {
+            if (i + 1 < argc) { opt.moteur.tuilesVote = std::max(0, std::atoi(argv[i + 1])); i++; }
+            continue;
+        }
+
+        if (a == "--timings") { timings = true; continue; }
+        if (a == "--fast-gradient") { opt.moteur.gradientRapide = true; continue; }
+        if (a == "--scale-step") {
+            if (i + 1 < argc) { opt.moteur.pasEchelles = std::max(1, std::atoi(argv[i + 1])); i++; }
+            continue;
+        }
+        if (a == "--face-scales") {
+            if (i + 1 < argc) { nEchellesFace = std::max(0, std::atoi(argv[i + 1])); i++; }
+            continue;
+        }
+        if (a == "--eye-radius-band") {
+            if (i + 1 < argc) {
+                float rMin = 0.0f, rMax = 0.0f;
+                if (std::sscanf(argv[i + 1], "%f:%f", &rMin, &rMax) == 2 && rMax >= rMin) {
+                    opt.moteur.ratioRayonOeilMin = rMin;
+                    opt.moteur.ratioRayonOeilMax = rMax;
+                }
+                i++;
+            }
+            continue;
+        }
+        if (a == "--pyramid") {
+            if (i + 1 < argc) { opt.moteur.pyramide = std::atoi(argv[i + 1]); i++; }
+            continue;
+        }
+        if (a == "--bary-integral") { opt.moteur.baryIntegrale = true; continue; }
+        if (a == "--face-volume") { opt.moteur.volumeFace = true; continue; }
+        if (a == "--face-engine") {
+            if (i + 1 < argc) { opt.moteur.visageEllipse = (std::string(argv[i + 1]) == "ellipse"); i++; }
+            continue;
+        }
+        if (a == "--eye-engine") {
+            if (i + 1 < argc) { opt.moteur.yeuxCercle = (std::string(argv[i + 1]) == "circle"); i++; }
+            continue;
+        }
+        if (a == "--roi-border") {
+            if (i + 1 < argc) { opt.moteur.bordRoiImage = (std::string(argv[i + 1]) == "image"); i++; }
+            continue;
+        }
 
         if (a == "--gui") { imageGui = true; continue; }
         if (a == "--gui-steps") { imageGui = true; guiSteps = true; continue; }
@@ -642,80 +931,57 @@ int main(int argc, char** argv) {
         if (a == "--no-gui" || a == "--headless") { imageGui = false; guiSteps = false; guiDelayMs = 0; continue; }
 
         // New args
-        if (a == "--no-eq") { useEqHist = false; continue; }
-        if (a == "--clahe") { useClahe = true; continue; }
+        if (a == "--no-eq") { opt.useEqHist = false; continue; }
+        if (a == "--clahe") { opt.useClahe = true; continue; }
         if (a == "--blur") {
-            if (i + 1 < argc) { blurK = std::atoi(argv[i + 1]); i++; }
+            if (i + 1 < argc) { opt.blurK = std::atoi(argv[i + 1]); i++; }
             continue;
         }
-        if (a == "--no-auto-threshold") { autoThr = false; continue; }
+        if (a == "--no-auto-threshold") { opt.autoThr = false; continue; }
         if (a == "--face-edge") {
-            if (i + 1 < argc) { faceEdgeUser = std::atoi(argv[i + 1]); i++; }
+            if (i + 1 < argc) { opt.faceEdgeUser = std::atoi(argv[i + 1]); i++; }
             continue;
         }
         if (a == "--eye-edge") {
-            if (i + 1 < argc) { eyeEdgeUser = std::atoi(argv[i + 1]); i++; }
+            if (i + 1 < argc) { opt.eyeEdgeUser = std::atoi(argv[i + 1]); i++; }
             continue;
         }
         if (a == "--face-min-score") {
-            if (i + 1 < argc) { faceMinUser = std::atoi(argv[i + 1]); i++; }
+            if (i + 1 < argc) { opt.faceMinUser = std::atoi(argv[i + 1]); i++; }
             continue;
         }
         if (a == "--eye-min-peak") {
-            if (i + 1 < argc) { eyeMinUser = std::atoi(argv[i + 1]); i++; }
+            if (i + 1 < argc) { opt.eyeMinUser = std::atoi(argv[i + 1]); i++; }
             continue;
         }
     }
 
-    // Defaults (same as your current baseline, but we will override if auto-threshold)
-    uint16_t EDGE_FACE = 140;
-    uint16_t EDGE_EYE  = 75;
-    uint16_t FACE_MIN_SCORE = 14;
-    uint16_t EYE_MIN_PEAK   = 5;
-
-    if (faceEdgeUser >= 0) EDGE_FACE = (uint16_t)clampInt(faceEdgeUser, 0, 65535);
-    if (eyeEdgeUser  >= 0) EDGE_EYE  = (uint16_t)clampInt(eyeEdgeUser, 0, 65535);
-    if (faceMinUser  >= 0) FACE_MIN_SCORE = (uint16_t)clampInt(faceMinUser, 0, 65535);
-    if (eyeMinUser   >= 0) EYE_MIN_PEAK   = (uint16_t)clampInt(eyeMinUser, 0, 65535);
-
-    std::vector<facemodel> faceModels;
-    {
-        const int scales[][2] = {
-            {25, 45}, {30, 55}, {35, 65}, {45, 85}, {55, 105}, {65, 125}, {75, 145}
-        };
-        for (int i = 0; i < 7; ++i) {
-            int rx = scales[i][0];
-            int ry = scales[i][1];
-            int tw = 2 * rx + 60;
-            int th = 2 * ry + 60;
-
-            grayImage t = templateEllipse(tw, th, (float)rx, (float)ry);
-            RTable lut = construireRTableDepuisTemplate(t, 50, 220);
-
-            facemodel fm;
-            fm.rx = rx; fm.ry = ry; fm.lut = lut;
-            faceModels.push_back(fm);
-        }
-    }
-
-    std::vector<eyemodel> eyeModels;
-    {
-        for (int r = 6; r <= 18; r += 2) {
-            int tw = 2 * r + 40;
-            int th = 2 * r + 40;
-
-            grayImage t = templateCercle(tw, th, (float)r);
-            RTable lut = construireRTableDepuisTemplate(t, 40, 220);
-
-            eyemodel em;
-            em.r = r; em.lut = lut;
-            eyeModels.push_back(em);
-        }
-    }
-
-    if (!doImage) {
+    if (!doImage && !rawStdin && servePath.empty() && shmName.empty() && batchSource.empty()) {
         std::cerr << "Usage: ght_face_eyes --image <path> [--gui|--no-gui] [--gui-steps] [--gui-delay-ms N]\n"
+                  << "       ght_face_eyes --raw-stdin [options] < frame\n"
+                  << "       ght_face_eyes --serve <unix-socket-path>\n"
+                  << "       ght_face_eyes --shm <name> [--shm-slots N] [--shm-max-size WxH]\n"
+                  << "       ght_face_eyes --batch <list-file|dir> [--threads N] [options]\n"
                   << "  Options:\n"
+                  << "    --raw-stdin             : read one raw frame (u32 width,height,stride,channels + 8-bit gray/BGR rows) from stdin\n"
+                  << "    --serve <path>          : keep the model bank loaded and answer binary requests on a unix socket\n"
+                  << "    --shm <name>            : serve frames from a shared-memory ring /dev/shm/<name> (default 4 slots of 1920x1080x3)\n"
+                  << "    --batch <list|dir>      : detect on every image of a list file (one path per line) or directory, NDJSON on stdout\n"
+                  << "    --threads <n>           : threads for batch images and per-model voting (default: cgroup CPU quota)\n"
+                  << "    --vote-tiles <n>        : band tiles per model vote on the pool, 0 = auto (default), 1 = off\n"
+                  << "    --timings               : per-stage wall times and work counters as JSON on stderr (also --serve/--shm/--batch)\n"
+                  << "    --fast-gradient         : squared magnitudes + LUT angle bins (no per-pixel sqrt/atan2, same results)\n"
+                  << "    --face-scales <n>       : face scale ladder of n sizes from rx 25 to 75 (default: the 7 historical scales)\n"
+                  << "    --scale-step <k>        : vote every k-th face scale, then hill-climb around the best (default 1 = all)\n"
+                  << "    --eye-radius-band <a:b> : only vote eye radii within [a, b] x face rx (e.g. 0.12:0.3; default: all radii)\n"
+                  << "    --face-engine <e>       : face votes: rtable (default, ellipse band template) | ellipse (analytic, 2 votes per edge and scale)\n"
+                  << "    --face-volume           : vote all face scales into one (x, y, scale) volume, joint peak, interpolated size\n"
+                  << "                              (slower than separate votes; not with --scale-step or --pyramid)\n"
+                  << "    --eye-engine <e>        : eye votes: rtable (default, ring template) | circle (analytic, 1 vote per edge and radius)\n"
+                  << "    --pyramid <f>           : coarse-to-fine search, face scales voted at 1/f (2 or 4) then refined locally\n"
+                  << "                              (full search instead when the coarse peaks are ambiguous: same face); 1 = off\n"
+                  << "    --bary-integral         : peak barycentres from summed-area tables of each accumulator (same results)\n"
+                  << "    --roi-border <mode>     : eye ROI border ring: clamp (default, recomputed at the ROI) | image (full-frame gradient)\n"
                   << "    --no-eq                 : disable histogram equalization\n"
                   << "    --clahe                 : use CLAHE instead of equalizeHist\n"
                   << "    --blur <oddK>           : gaussian blur kernel (odd). 0 disables. default=5\n"
@@ -726,53 +992,70 @@ int main(int argc, char** argv) {
                   << "    --eye-min-peak <v>      : override EYE_MIN_PEAK\n";
         return 2;
     }
-
-    cv::Mat bgr = cv::imread(imagePath);
-    if (bgr.empty()) {
-        std::cerr << "Erreur: impossible de lire l'image: " << imagePath << "\n";
-        return 1;
-    }
-    if (bgr.channels() != 3) {
-        std::cerr << "Erreur: image doit etre en BGR (3 canaux)\n";
-        return 1;
+    // the volume votes every scale at full resolution: neither option would apply
+    if (opt.moteur.volumeFace && opt.moteur.pasEchelles > 1) {
+        std::cerr << "Erreur: --face-volume vote toutes les echelles, incompatible avec --scale-step\n";
+        return 2;
     }
-
-    // Preprocess
-    cv::Mat gray;
-    cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
-
-    if (useClahe) {
-        cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE(2.0, cv::Size(8, 8));
-        clahe->apply(gray, gray);
-    } else if (useEqHist) {
-        cv::equalizeHist(gray, gray);
+    if (opt.moteur.volumeFace && opt.moteur.pyramide > 1) {
+        std::cerr << "Erreur: --face-volume et --pyramid sont incompatibles\n";
+        return 2;
     }
 
-    if (blurK > 0) {
-        if (blurK % 2 == 0) blurK += 1;
-        blurK = std::max(1, blurK);
-        cv::GaussianBlur(gray, gray, cv::Size(blurK, blurK), 0.0);
+    // one pool for the whole process: --threads N means N busy threads (N - 1 workers
+    // plus the caller); default is the cgroup CPU quota
+    const int nThreadsEff = nThreads > 0 ? nThreads : threadsParDefaut();
+    std::unique_ptr<PoolTaches> pool;
+    if (nThreadsEff > 1) {
+        pool.reset(new PoolTaches(nThreadsEff - 1));
+        opt.moteur.pool = pool.get();
     }
 
-    grayImage g = matToGrayImageU8(gray);
+    const BanqueModeles banque = construireBanqueModeles(nEchellesFace);
+    const Service svc{banque, opt.moteur, timings};
 
-    // Auto thresholds based on gradient percentiles
-    if (autoThr && faceEdgeUser < 0 && eyeEdgeUser < 0) {
-        ChampGradient cg = sobel(g);
-        // These heuristics are designed to prevent "no votes" on low-contrast frames.
-        // p90 tends to be "strong edges"; we pick fractions for face/eyes.
-        uint16_t p90 = magPercentile(cg, 0.90);
-        uint16_t p80 = magPercentile(cg, 0.80);
-
-        // guard rails
-        uint16_t faceT = (uint16_t)clampInt((int)std::lround((double)p90 * 0.70), 20, 600);
-        uint16_t eyeT  = (uint16_t)clampInt((int)std::lround((double)p80 * 0.55), 15, 500);
+    if (!servePath.empty()) {
+        // preprocessing/threshold options travel with each request
+        return servir(servePath, svc);
+    }
+    if (!shmName.empty()) {
+        return servirAnneau(shmName, (uint32_t)std::max(1, shmSlots), shmMaxW, shmMaxH, svc);
+    }
+    if (!batchSource.empty()) {
+        return traiterBatch(batchSource, banque, opt, timings);
+    }
 
-        EDGE_FACE = faceT;
-        EDGE_EYE  = eyeT;
+    MesuresDetection mesures;
+    Horloge::time_point t0 = Horloge::now();
+    cv::Mat src;                  // BGR, or 8-bit gray for raw frames
+    std::vector<uint8_t> pixels;  // backs src for --raw-stdin
+    if (rawStdin) {
+        if (!lireTrameStdin(pixels, src)) {
+            std::cerr << "Erreur: trame brute invalide sur stdin\n";
+            return 1;
+        }
+    } else {
+        src = cv::imread(imagePath);
+        if (src.empty()) {
+            std::cerr << "Erreur: impossible de lire l'image: " << imagePath << "\n";
+            return 1;
+        }
+        if (src.channels() != 3) {
+            std::cerr << "Erreur: image doit etre en BGR (3 canaux)\n";
+            return 1;
+        }
+        if (!tailleImageValide(src.cols, src.rows)) {
+            std::cerr << "Erreur: image trop grande (cote max " << kCoteMaxImage << ")\n";
+            return 1;
+        }
     }
 
-    faceeyes r = detectfaceeyes(g, faceModels, eyeModels, EDGE_FACE, EDGE_EYE, FACE_MIN_SCORE, EYE_MIN_PEAK);
+    if (timings) noterImread(mesures, t0);
+
+    cv::Mat gray;
+    Seuils seuils;
+    faceeyes r = analyser(src, banque, opt, seuils, &gray, false, timings ? &mesures : nullptr);
+    if (timings) ecrireMesures(rawStdin ? std::string("stdin") : imagePath, mesures, microsDepuis(t0));
 
     // Print result (keep parser-compatible format)
     if (!r.faceOk) {
@@ -788,18 +1071,20 @@ int main(int argc, char** argv) {
     }
 
     // Also print debug thresholds to stderr (doesn't break stdout parser)
-    std::cerr << "[DBG] EDGE_FACE=" << EDGE_FACE
-              << " EDGE_EYE=" << EDGE_EYE
-              << " FACE_MIN_SCORE=" << FACE_MIN_SCORE
-              << " EYE_MIN_PEAK=" << EYE_MIN_PEAK
-              << " autoThr=" << (autoThr ? "1" : "0")
-              << " eq=" << (useEqHist ? "1" : "0")
-              << " clahe=" << (useClahe ? "1" : "0")
-              << " blurK=" << blurK
+    std::cerr << "[DBG] EDGE_FACE=" << seuils.edgeFace
+              << " EDGE_EYE=" << seuils.edgeEye
+              << " FACE_MIN_SCORE=" << seuils.faceMinScore
+              << " EYE_MIN_PEAK=" << seuils.eyeMinPeak
+              << " autoThr=" << (opt.autoThr ? "1" : "0")
+              << " eq=" << (opt.useEqHist ? "1" : "0")
+              << " clahe=" << (opt.useClahe ? "1" : "0")
+              << " blurK=" << normaliserBlurK(opt.blurK)
               << "\n";
 
     if (imageGui) {
-        cv::Mat overlay = bgr.clone();
+        cv::Mat overlay;
+        if (src.channels() == 3) overlay = src.clone();
+        else cv::cvtColor(src, overlay, cv::COLOR_GRAY2BGR);
         drawOverlay(overlay, r);
 
         showStep("Frame", overlay, guiSteps, guiDelayMs);
@@ -0,0 +1,175 @@
+// FILE: vision/src/ght_pool.cpp
+#include "ght_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <sched.h>
+
+// -------------------- CPU quota --------------------
+// Returns quota/period rounded up, or 0 when there is no limit / no readable file.
+static int quotaCgroup() {
+    // cgroup v2: "<quota|max> <period>"
+    {
+        std::ifstream f("/sys/fs/cgroup/cpu.max");
+        std::string quota;
+        long period = 0;
+        if (f >> quota >> period) {
+            const long q = std::strtol(quota.c_str(), nullptr, 10);  // "max" -> 0
+            if (q <= 0 || period <= 0) return 0;
+            return (int)std::ceil((double)q / (double)period);
+        }
+    }
+    // cgroup v1
+    {
+        std::ifstream fq("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+        std::ifstream fp("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+        long quota = -1, period = 0;
+        if ((fq >> quota) && (fp >> period) && quota > 0 && period > 0) {
+            return (int)std::ceil((double)quota / (double)period);
+        }
+    }
+    return 0;
+}
+
+int threadsParDefaut() {
+    int n = (int)std::thread::hardware_concurrency();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) n = CPU_COUNT(&set);
+    const int quota = quotaCgroup();
+    if (quota > 0) n = std::min(n, quota);
+    return std::max(1, n);
+}
+
+// -------------------- pool --------------------
+
+PoolTaches::PoolTaches(int nWorkers) {
+    nWorkers = std::max(0, nWorkers);
+    for (int i = 0; i <= nWorkers; ++i) {
+        files_.push_back(std::make_unique<File>());
+        files_.back()->q.reserve(64);
+    }
+    for (int i = 0; i < nWorkers; ++i) threads_.emplace_back([this, i]() { boucle((size_t)i); });
+}
+
+PoolTaches::~PoolTaches() {
+    {
+        std::lock_guard<std::mutex> lk(mSommeil_);
+        arret_ = true;
+    }
+    cvSommeil_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+thread_local PoolTaches::Groupe* PoolTaches::courant_ = nullptr;
+
+bool PoolTaches::dansGroupe(const Groupe* g, const Groupe* filtre) {
+    for (; g; g = g->parent) {
+        if (g == filtre) return true;
+    }
+    return false;
+}
+
+bool PoolTaches::essayerExecuter(size_t id, const Groupe* filtre) {
+    Tache t;
+    bool trouve = false;
+    {
+        File& f = *files_[id];
+        std::lock_guard<std::mutex> lk(f.m);
+        for (auto it = f.q.end(); it != f.q.begin();) {
+            --it;
+            if (filtre && !dansGroupe(it->g, filtre)) continue;
+            t = *it;
+            f.q.erase(it);
+            trouve = true;
+            break;
+        }
+    }
+    for (size_t k = 1; !trouve && k < files_.size(); ++k) {
+        File& f = *files_[(id + k) % files_.size()];
+        std::lock_guard<std::mutex> lk(f.m);
+        for (auto it = f.q.begin(); it != f.q.end(); ++it) {
+            if (filtre && !dansGroupe(it->g, filtre)) continue;
+            t = *it;
+            f.q.erase(it);
+            trouve = true;
+            break;
+        }
+    }
+    if (!trouve) return false;
+
+    enFile_.fetch_sub(1, std::memory_order_relaxed);
+    std::exception_ptr erreur;
+    Groupe* avant = courant_;
+    courant_ = t.g;
+    try {
+        t.appel(t.f, t.i);
+    } catch (...) {
+        erreur = std::current_exception();
+    }
+    courant_ = avant;
+    {
+        // decrement under the group lock: the waiter re-takes it before the group dies
+        std::lock_guard<std::mutex> lk(t.g->m);
+        if (erreur && !t.g->erreur) t.g->erreur = erreur;
+        if (t.g->restant.fetch_sub(1, std::memory_order_acq_rel) == 1) t.g->cv.notify_all();
+    }
+    return true;
+}
+
+void PoolTaches::boucle(size_t id) {
+    for (;;) {
+        if (essayerExecuter(id)) continue;
+        std::unique_lock<std::mutex> lk(mSommeil_);
+        cvSommeil_.wait(lk, [&]() { return arret_ || enFile_.load(std::memory_order_relaxed) > 0; });
+        if (arret_ && enFile_.load(std::memory_order_relaxed) == 0) return;
+    }
+}
+
+void PoolTaches::executer(size_t n, Appel appel, const void* f) {
+    if (n == 0) return;
+    if (n == 1 || threads_.empty()) {
+        for (size_t i = 0; i < n; ++i) appel(f, i);
+        return;
+    }
+
+    Groupe g;
+    g.restant.store(n, std::memory_order_relaxed);
+    g.parent = courant_;
+
+    // spread the tasks over the worker deques, starting at a rotating offset
+    // (counted before pushing so a fast thief never drives enFile_ below zero)
+    const size_t nf = files_.size();
+    {
+        std::lock_guard<std::mutex> lk(mSommeil_);
+        enFile_.fetch_add(n, std::memory_order_relaxed);
+    }
+    const size_t depart = prochaine_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < n; ++i) {
+        File& file = *files_[(depart + i) % nf];
+        std::lock_guard<std::mutex> lk(file.m);
+        file.q.push_back(Tache{appel, f, i, &g});
+    }
+    cvSommeil_.notify_all();
+
+    // help with our group (and what it nests) until it is done; the external deque is the
+    // last one
+    const size_t moi = nf - 1;
+    while (g.restant.load(std::memory_order_acquire) > 0) {
+        if (essayerExecuter(moi, &g)) continue;
+        std::unique_lock<std::mutex> lk(g.m);
+        g.cv.wait_for(lk, std::chrono::milliseconds(1),
+                      [&]() { return g.restant.load(std::memory_order_acquire) == 0; });
+    }
+    std::exception_ptr erreur;
+    {
+        std::lock_guard<std::mutex> lk(g.m);
+        erreur = g.erreur;
+    }
+    if (erreur) std::rethrow_exception(erreur);
+}
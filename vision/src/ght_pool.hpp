@@ -0,0 +1,78 @@
+// FILE: vision/src/ght_pool.hpp
+// Work-stealing thread pool: one deque per worker. A worker takes its newest task
+// (back of its own deque) and, when idle, steals the oldest task of another worker.
+// executerParallele() is re-entrant: the waiting thread keeps executing the queued
+// tasks of its own group and of the groups nested inside it (never an unrelated
+// outer task, so waits do not stack), and a task may itself call executerParallele().
+// Tasks are a pointer to the caller's callable and queues keep their capacity, so once
+// the queues have grown to the widest fan-out a call allocates nothing.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// CPUs this process may use: the cgroup CPU quota (cpu.max, or cfs_quota_us/cfs_period_us
+// on cgroup v1) rounded up, capped by the affinity mask. At least 1.
+int threadsParDefaut();
+
+class PoolTaches {
+public:
+    // nWorkers background threads; the thread calling executerParallele() also works, so a
+    // pool for N threads of compute has N - 1 workers. 0 workers runs everything inline.
+    explicit PoolTaches(int nWorkers);
+    ~PoolTaches();
+
+    PoolTaches(const PoolTaches&) = delete;
+    PoolTaches& operator=(const PoolTaches&) = delete;
+
+    int taille() const { return (int)threads_.size(); }
+
+    // Runs f(0..n-1) on the pool; the calling thread participates. Returns when all are done;
+    // if some f(i) threw, the first exception is then rethrown (the others still ran).
+    template <typename F>
+    void executerParallele(size_t n, const F& f) { executer(n, &appeler<F>, &f); }
+
+private:
+    using Appel = void (*)(const void* f, size_t i);
+    template <typename F>
+    static void appeler(const void* f, size_t i) { (*static_cast<const F*>(f))(i); }
+    void executer(size_t n, Appel appel, const void* f);
+
+    struct Groupe {
+        std::atomic<size_t> restant{0};
+        std::mutex m;
+        std::condition_variable cv;
+        std::exception_ptr erreur;   // first exception of the group, under m
+        Groupe* parent = nullptr;    // group of the task that created this one (outlives it)
+    };
+    struct Tache {
+        Appel appel = nullptr;
+        const void* f = nullptr;
+        size_t i = 0;
+        Groupe* g = nullptr;
+    };
+    struct File {
+        std::mutex m;
+        std::vector<Tache> q;   // oldest first; short, so erasing from the front is cheap
+    };
+
+    // filtre: only tasks of this group or of groups nested in it (nullptr = any task)
+    bool essayerExecuter(size_t id, const Groupe* filtre = nullptr);
+    static bool dansGroupe(const Groupe* g, const Groupe* filtre);
+    static thread_local Groupe* courant_;   // group of the task this thread is running
+    void boucle(size_t id);
+
+    std::vector<std::unique_ptr<File>> files_;  // one per worker + one for external callers
+    std::vector<std::thread> threads_;
+    std::mutex mSommeil_;
+    std::condition_variable cvSommeil_;
+    std::atomic<size_t> enFile_{0};
+    std::atomic<size_t> prochaine_{0};
+    bool arret_ = false;
+};
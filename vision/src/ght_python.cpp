@@ -0,0 +1,183 @@
+// FILE: vision/src/ght_python.cpp
+// _ght: CPython extension over libght. Frames are read in place through the buffer
+// protocol (numpy arrays included, no copy) and the GIL is released while detecting.
+//
+//   import _ght
+//   det = _ght.Detector()              # model bank built once
+//   r = det.detect(frame_bgr)          # (H,W,3) or (H,W) uint8, any row stride
+//   r.face_ok, r.face_x, r.eye1_x, ... # _ght.Result (struct sequence)
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "ght.h"
+
+static PyTypeObject* gResultType = nullptr;
+
+static PyStructSequence_Field kResultFields[] = {
+    {"face_ok", "face found"},
+    {"face_x", nullptr}, {"face_y", nullptr},
+    {"face_rx", "face model half-width"}, {"face_ry", "face model half-height"},
+    {"eyes_ok", "eye pair found"},
+    {"eye1_x", nullptr}, {"eye1_y", nullptr},
+    {"eye2_x", nullptr}, {"eye2_y", nullptr},
+    {"eye_r", "eye model radius"},
+    {"edge_face", "face edge threshold used"}, {"edge_eye", "eye edge threshold used"},
+    {"face_min_score", nullptr}, {"eye_min_peak", nullptr},
+    {nullptr, nullptr}
+};
+
+static PyStructSequence_Desc kResultDesc = {
+    "_ght.Result",
+    "Detection result (same fields as ght_result / the daemon ResultatFil).",
+    kResultFields,
+    15
+};
+
+struct DetectorObject {
+    PyObject_HEAD
+    ght_detector* det;
+};
+
+static PyObject* Detector_new(PyTypeObject* type, PyObject*, PyObject*) {
+    DetectorObject* self = (DetectorObject*)type->tp_alloc(type, 0);
+    if (!self) return nullptr;
+
+    Py_BEGIN_ALLOW_THREADS
+    self->det = ght_detector_create();
+    Py_END_ALLOW_THREADS
+
+    if (!self->det) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return (PyObject*)self;
+}
+
+static void Detector_dealloc(DetectorObject* self) {
+    ght_detector_free(self->det);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject* Detector_detect(DetectorObject* self, PyObject* args, PyObject* kwds) {
+    static const char* kwlist[] = {
+        "frame", "equalize", "clahe", "blur_k", "auto_threshold",
+        "face_edge", "eye_edge", "face_min_score", "eye_min_peak", nullptr
+    };
+    ght_params p;
+    ght_params_default(&p);
+
+    PyObject* frame = nullptr;
+    int equalize = p.equalize, clahe = p.clahe, autoThr = p.auto_threshold;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$ppipiiii", (char**)kwlist,
+                                     &frame, &equalize, &clahe, &p.blur_k, &autoThr,
+                                     &p.face_edge, &p.eye_edge, &p.face_min_score, &p.eye_min_peak)) {
+        return nullptr;
+    }
+    p.equalize = equalize;
+    p.clahe = clahe;
+    p.auto_threshold = autoThr;
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(frame, &view, PyBUF_STRIDES | PyBUF_FORMAT) < 0) return nullptr;
+
+    const bool u8 = view.itemsize == 1 && (!view.format || view.format[0] == 'B' || view.format[0] == 'b');
+    const int channels = view.ndim == 3 ? (int)view.shape[2] : 1;
+    const bool layoutOk =
+        (view.ndim == 2 || view.ndim == 3) &&
+        (channels == 1 || channels == 3) &&
+        view.strides[0] > 0 &&
+        view.strides[1] == channels &&
+        (view.ndim == 2 || view.strides[2] == 1);
+    if (!u8 || !layoutOk) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError,
+                        "frame must be uint8 (H,W) or (H,W,3) with contiguous pixels in each row");
+        return nullptr;
+    }
+
+    ght_result r;
+    int rc;
+    Py_BEGIN_ALLOW_THREADS
+    rc = ght_detect(self->det, (const uint8_t*)view.buf, (int)view.shape[1], (int)view.shape[0],
+                    (size_t)view.strides[0], channels, &p, &r);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+
+    if (rc == GHT_ERR_ALLOC) return PyErr_NoMemory();
+    if (rc == GHT_ERR_ARG) {
+        PyErr_SetString(PyExc_ValueError, "frame sides must be 1..32767 pixels");
+        return nullptr;
+    }
+    if (rc != GHT_OK) {
+        PyErr_Format(PyExc_RuntimeError, "ght_detect failed (%d)", rc);
+        return nullptr;
+    }
+
+    PyObject* res = PyStructSequence_New(gResultType);
+    if (!res) return nullptr;
+    const int32_t vals[15] = {
+        r.face_ok, r.face_x, r.face_y, r.face_rx, r.face_ry,
+        r.eyes_ok, r.eye1_x, r.eye1_y, r.eye2_x, r.eye2_y, r.eye_r,
+        r.edge_face, r.edge_eye, r.face_min_score, r.eye_min_peak
+    };
+    for (Py_ssize_t i = 0; i < 15; ++i) {
+        PyObject* v = PyLong_FromLong(vals[i]);
+        if (!v) {
+            Py_DECREF(res);
+            return nullptr;
+        }
+        PyStructSequence_SetItem(res, i, v);
+    }
+    return res;
+}
+
+static PyMethodDef kDetectorMethods[] = {
+    {"detect", (PyCFunction)(void (*)(void))Detector_detect, METH_VARARGS | METH_KEYWORDS,
+     "detect(frame, *, equalize=True, clahe=False, blur_k=5, auto_threshold=True,\n"
+     "       face_edge=-1, eye_edge=-1, face_min_score=-1, eye_min_peak=-1) -> Result"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyTypeObject DetectorType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+};
+
+static PyModuleDef kModule = {
+    PyModuleDef_HEAD_INIT,
+    "_ght",
+    "In-process GHT face/eyes detector (libght).",
+    -1,
+    nullptr, nullptr, nullptr, nullptr, nullptr
+};
+
+PyMODINIT_FUNC PyInit__ght(void) {
+    DetectorType.tp_name = "_ght.Detector";
+    DetectorType.tp_doc = "Detector() builds the face/eye model bank; thread-safe, reusable.";
+    DetectorType.tp_basicsize = sizeof(DetectorObject);
+    DetectorType.tp_flags = Py_TPFLAGS_DEFAULT;
+    DetectorType.tp_new = Detector_new;
+    DetectorType.tp_dealloc = (destructor)Detector_dealloc;
+    DetectorType.tp_methods = kDetectorMethods;
+    if (PyType_Ready(&DetectorType) < 0) return nullptr;
+
+    gResultType = PyStructSequence_NewType(&kResultDesc);
+    if (!gResultType) return nullptr;
+
+    PyObject* m = PyModule_Create(&kModule);
+    if (!m) return nullptr;
+
+    Py_INCREF(&DetectorType);
+    if (PyModule_AddObject(m, "Detector", (PyObject*)&DetectorType) < 0) {
+        Py_DECREF(&DetectorType);
+        Py_DECREF(m);
+        return nullptr;
+    }
+    Py_INCREF(gResultType);
+    if (PyModule_AddObject(m, "Result", (PyObject*)gResultType) < 0) {
+        Py_DECREF(gResultType);
+        Py_DECREF(m);
+        return nullptr;
+    }
+    PyModule_AddIntConstant(m, "API_VERSION", ght_api_version());
+    return m;
+}
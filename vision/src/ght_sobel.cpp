@@ -0,0 +1,447 @@
+// FILE: vision/src/ght_sobel.cpp
+// Sobel gradient field. The interior is computed row by row without border clamping
+// (SSE4.1 / AVX2 picked at runtime, scalar fallback); the one-pixel border ring keeps
+// the clamped reads. Output is bit-identical across paths: gx^2+gy^2 is an exact
+// integer in float, sqrt is correctly rounded in both scalar and vector units, and
+// sqrt of an integer below 2^21 never lands on a .5 tie, so round-to-nearest == lround.
+#include "ght_core.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GHT_SOBEL_X86 1
+#include <immintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// -------------------- utils --------------------
+static int binDeg(float radians) {
+    float deg = radians * 180.0f / float(M_PI);
+    int b = (int)std::lround(deg);
+    b = b % 360;
+    if (b < 0) b += 360;
+    return b;
+}
+
+// -------------------- row kernels --------------------
+// Interior columns [x0, x1) of one row; r0/r1/r2 are rows y-1, y, y+1.
+static void ligneGradScalaire(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+                              int x0, int x1, int16_t* gx, int16_t* gy) {
+    for (int x = x0; x < x1; ++x) {
+        int a0 = r0[x - 1], a1 = r0[x], a2 = r0[x + 1];
+        int c0 = r2[x - 1], c1 = r2[x], c2 = r2[x + 1];
+        gx[x] = (int16_t)((a2 - a0) + 2 * (r1[x + 1] - r1[x - 1]) + (c2 - c0));
+        gy[x] = (int16_t)((c0 + 2 * c1 + c2) - (a0 + 2 * a1 + a2));
+    }
+}
+
+static void ligneMagScalaire(const int16_t* gx, const int16_t* gy, int x0, int x1, uint16_t* mag) {
+    for (int x = x0; x < x1; ++x) {
+        float m = std::sqrt((float)gx[x] * (float)gx[x] + (float)gy[x] * (float)gy[x]);
+        mag[x] = (uint16_t)clampInt((int)std::lround(m), 0, 65535);
+    }
+}
+
+#ifdef GHT_SOBEL_X86
+__attribute__((target("sse4.1")))
+static void ligneGradSse41(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+                           int x0, int x1, int16_t* gx, int16_t* gy) {
+    int x = x0;
+    for (; x + 8 <= x1; x += 8) {
+        __m128i a0 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r0 + x - 1)));
+        __m128i a1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r0 + x)));
+        __m128i a2 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r0 + x + 1)));
+        __m128i b0 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r1 + x - 1)));
+        __m128i b2 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r1 + x + 1)));
+        __m128i c0 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r2 + x - 1)));
+        __m128i c1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r2 + x)));
+        __m128i c2 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(r2 + x + 1)));
+
+        __m128i dx = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(a2, a0), _mm_sub_epi16(c2, c0)),
+                                   _mm_slli_epi16(_mm_sub_epi16(b2, b0), 1));
+        __m128i haut = _mm_add_epi16(_mm_add_epi16(a0, a2), _mm_slli_epi16(a1, 1));
+        __m128i bas  = _mm_add_epi16(_mm_add_epi16(c0, c2), _mm_slli_epi16(c1, 1));
+        _mm_storeu_si128((__m128i*)(gx + x), dx);
+        _mm_storeu_si128((__m128i*)(gy + x), _mm_sub_epi16(bas, haut));
+    }
+    ligneGradScalaire(r0, r1, r2, x, x1, gx, gy);
+}
+
+__attribute__((target("sse4.1")))
+static void ligneMagSse41(const int16_t* gx, const int16_t* gy, int x0, int x1, uint16_t* mag) {
+    int x = x0;
+    for (; x + 8 <= x1; x += 8) {
+        __m128i vx = _mm_loadu_si128((const __m128i*)(gx + x));
+        __m128i vy = _mm_loadu_si128((const __m128i*)(gy + x));
+        __m128 xl = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(vx));
+        __m128 xh = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(vx, 8)));
+        __m128 yl = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(vy));
+        __m128 yh = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(vy, 8)));
+        __m128i ml = _mm_cvtps_epi32(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(xl, xl), _mm_mul_ps(yl, yl))));
+        __m128i mh = _mm_cvtps_epi32(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(xh, xh), _mm_mul_ps(yh, yh))));
+        _mm_storeu_si128((__m128i*)(mag + x), _mm_packus_epi32(ml, mh));
+    }
+    ligneMagScalaire(gx, gy, x, x1, mag);
+}
+
+__attribute__((target("avx2")))
+static void ligneGradAvx2(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2,
+                          int x0, int x1, int16_t* gx, int16_t* gy) {
+    int x = x0;
+    for (; x + 16 <= x1; x += 16) {
+        __m256i a0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r0 + x - 1)));
+        __m256i a1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r0 + x)));
+        __m256i a2 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r0 + x + 1)));
+        __m256i b0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r1 + x - 1)));
+        __m256i b2 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r1 + x + 1)));
+        __m256i c0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r2 + x - 1)));
+        __m256i c1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r2 + x)));
+        __m256i c2 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(r2 + x + 1)));
+
+        __m256i dx = _mm256_add_epi16(_mm256_add_epi16(_mm256_sub_epi16(a2, a0), _mm256_sub_epi16(c2, c0)),
+                                      _mm256_slli_epi16(_mm256_sub_epi16(b2, b0), 1));
+        __m256i haut = _mm256_add_epi16(_mm256_add_epi16(a0, a2), _mm256_slli_epi16(a1, 1));
+        __m256i bas  = _mm256_add_epi16(_mm256_add_epi16(c0, c2), _mm256_slli_epi16(c1, 1));
+        _mm256_storeu_si256((__m256i*)(gx + x), dx);
+        _mm256_storeu_si256((__m256i*)(gy + x), _mm256_sub_epi16(bas, haut));
+    }
+    ligneGradSse41(r0, r1, r2, x, x1, gx, gy);
+}
+
+__attribute__((target("avx2")))
+static void ligneMagAvx2(const int16_t* gx, const int16_t* gy, int x0, int x1, uint16_t* mag) {
+    int x = x0;
+    for (; x + 16 <= x1; x += 16) {
+        __m256i vx = _mm256_loadu_si256((const __m256i*)(gx + x));
+        __m256i vy = _mm256_loadu_si256((const __m256i*)(gy + x));
+        __m256 xl = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(vx)));
+        __m256 xh = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(vx, 1)));
+        __m256 yl = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(vy)));
+        __m256 yh = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(vy, 1)));
+        __m256i ml = _mm256_cvtps_epi32(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(xl, xl), _mm256_mul_ps(yl, yl))));
+        __m256i mh = _mm256_cvtps_epi32(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(xh, xh), _mm256_mul_ps(yh, yh))));
+        // packus works per 128-bit lane: restore pixel order afterwards
+        __m256i m = _mm256_permute4x64_epi64(_mm256_packus_epi32(ml, mh), 0xD8);
+        _mm256_storeu_si256((__m256i*)(mag + x), m);
+    }
+    ligneMagSse41(gx, gy, x, x1, mag);
+}
+#endif
+
+// -------------------- dispatch --------------------
+struct NoyauxSobel {
+    void (*grad)(const uint8_t*, const uint8_t*, const uint8_t*, int, int, int16_t*, int16_t*);
+    void (*mag)(const int16_t*, const int16_t*, int, int, uint16_t*);
+    const char* nom;
+};
+
+// GHT_SIMD=scalar|sse4.1|avx2 caps the level (benchmarks, bit-identity checks).
+static NoyauxSobel choisirNoyaux() {
+    NoyauxSobel n{ligneGradScalaire, ligneMagScalaire, "scalar"};
+#ifdef GHT_SOBEL_X86
+    const char* env = std::getenv("GHT_SIMD");
+    const std::string plafond = env ? env : "";
+    if (plafond == "scalar") return n;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) n = NoyauxSobel{ligneGradSse41, ligneMagSse41, "sse4.1"};
+    if (plafond == "sse4.1") return n;
+    if (__builtin_cpu_supports("avx2")) n = NoyauxSobel{ligneGradAvx2, ligneMagAvx2, "avx2"};
+#endif
+    return n;
+}
+
+static const NoyauxSobel& noyaux() {
+    static const NoyauxSobel n = choisirNoyaux();
+    return n;
+}
+
+const char* sobelIsa() {
+    return noyaux().nom;
+}
+
+// -------------------- gradients --------------------
+// gx/gy of row y: vector kernel on the interior, clamped reads on the border ring.
+static void ligneGradient(const grayView& img, int y, const NoyauxSobel& k, int16_t* gx, int16_t* gy) {
+    auto at = [&](int yy, int xx) -> int {
+        xx = clampInt(xx, 0, img.w - 1);
+        yy = clampInt(yy, 0, img.h - 1);
+        return (int)img.at(yy, xx);
+    };
+
+    // same arithmetic as the interior
+    auto bord = [&](int x) {
+        gx[x] = (int16_t)(
+            -1 * at(y - 1, x - 1) + 1 * at(y - 1, x + 1) +
+            -2 * at(y,     x - 1) + 2 * at(y,     x + 1) +
+            -1 * at(y + 1, x - 1) + 1 * at(y + 1, x + 1));
+        gy[x] = (int16_t)(
+            -1 * at(y - 1, x - 1) + -2 * at(y - 1, x) + -1 * at(y - 1, x + 1) +
+             1 * at(y + 1, x - 1) +  2 * at(y + 1, x) +  1 * at(y + 1, x + 1));
+    };
+
+    if (y == 0 || y == img.h - 1 || img.w < 3) {
+        for (int x = 0; x < img.w; ++x) bord(x);
+        return;
+    }
+    const uint8_t* r1 = img.p + (size_t)y * img.stride;
+    k.grad(r1 - img.stride, r1, r1 + img.stride, 1, img.w - 1, gx, gy);
+    bord(0);
+    bord(img.w - 1);
+}
+
+void sobel(const grayView& img, ChampGradient& cg, std::vector<int16_t>& lignes) {
+    cg.w = img.w;
+    cg.h = img.h;
+    cg.mag.assign((size_t)cg.w * (size_t)cg.h, 0);
+    cg.ang.assign((size_t)cg.w * (size_t)cg.h, 0);
+    cg.mag2.clear();
+    if (img.w <= 0 || img.h <= 0) return;
+
+    const NoyauxSobel& k = noyaux();
+    lignes.resize(2 * (size_t)img.w);
+    int16_t* gx = lignes.data();
+    int16_t* gy = gx + img.w;
+
+    for (int y = 0; y < img.h; ++y) {
+        ligneGradient(img, y, k, gx, gy);
+
+        uint16_t* m = &cg.m(y, 0);
+        uint16_t* a = &cg.a(y, 0);
+        k.mag(gx, gy, 0, img.w, m);
+        for (int x = 0; x < img.w; ++x) {
+            a[x] = (uint16_t)binDeg(std::atan2((float)gy[x], (float)gx[x]));
+        }
+    }
+}
+
+void composantesSobel(const grayView& img, std::vector<int16_t>& gx, std::vector<int16_t>& gy) {
+    gx.assign((size_t)std::max(0, img.w) * (size_t)std::max(0, img.h), 0);
+    gy.assign(gx.size(), 0);
+    if (img.w <= 0 || img.h <= 0) return;
+    const NoyauxSobel& k = noyaux();
+    for (int y = 0; y < img.h; ++y) {
+        ligneGradient(img, y, k, &gx[(size_t)y * (size_t)img.w], &gy[(size_t)y * (size_t)img.w]);
+    }
+}
+
+ChampGradient sobel(const grayView& img) {
+    ChampGradient cg;
+    std::vector<int16_t> lignes;
+    sobel(img, cg, lignes);
+    return cg;
+}
+
+// -------------------- fast gradient (sobelRapide) --------------------
+// First octant (0 <= b <= a, b = |gy|, a = |gx| or swapped): cell i holds ratios b/a in
+// [i/N, (i+1)/N) and stores its degree bin, or -1 when a bin edge (k+0.5 deg) lies within
+// one cell of it. b * inv[a] may land one cell off; binDeg's own float error near an edge
+// is orders of magnitude below a cell, so every non-guard cell matches binDeg exactly.
+static const int kCellulesRatio = 8192;
+static const int kGradMax = 1020;  // |gx|, |gy| <= 4 * 255
+
+struct TablesAngle {
+    std::vector<int8_t> bin;  // kCellulesRatio + 1 cells (ratio 1.0 included)
+    std::vector<float> inv;   // kCellulesRatio / a, a in [1, kGradMax]
+};
+
+static TablesAngle construireTablesAngle() {
+    TablesAngle t;
+    t.bin.resize((size_t)kCellulesRatio + 1);
+    t.inv.assign((size_t)kGradMax + 1, 0.0f);
+    auto degres = [](double r) { return (int)std::lround(std::atan(r) * 180.0 / M_PI); };
+    for (int i = 0; i <= kCellulesRatio; ++i) {
+        int lo = degres((double)(i - 1) / kCellulesRatio);
+        int hi = degres((double)(i + 2) / kCellulesRatio);
+        t.bin[(size_t)i] = (int8_t)(lo == hi ? lo : -1);
+    }
+    for (int a = 1; a <= kGradMax; ++a) t.inv[(size_t)a] = (float)kCellulesRatio / (float)a;
+    return t;
+}
+
+static const TablesAngle& tablesAngle() {
+    static const TablesAngle t = construireTablesAngle();
+    return t;
+}
+
+static inline uint16_t binRapide(int gx, int gy, const TablesAngle& t) {
+    int a = std::abs(gx), b = std::abs(gy);
+    const bool echange = b > a;
+    if (echange) std::swap(a, b);
+    if (a == 0) return 0;  // atan2(0, 0) == 0
+
+    int k = t.bin[(size_t)std::min((int)((float)b * t.inv[(size_t)a]), kCellulesRatio)];
+    if (k < 0) return (uint16_t)binDeg(std::atan2((float)gy, (float)gx));
+    if (echange) k = 90 - k;
+
+    // no .5 ties outside the guard band, so rounding commutes with the reflections
+    int d;
+    if (gx >= 0) d = (gy >= 0) ? k : 360 - k;
+    else         d = (gy >= 0) ? 180 - k : 180 + k;
+    return (uint16_t)(d % 360);
+}
+
+uint16_t binSobel(int gx, int gy) {
+    return (uint16_t)binDeg(std::atan2((float)gy, (float)gx));
+}
+
+uint16_t binSobelRapide(int gx, int gy) {
+    return binRapide(gx, gy, tablesAngle());
+}
+
+void sobelRapide(const grayView& img, ChampGradient& cg, std::vector<int16_t>& lignes, uint16_t seuilAngle) {
+    cg.w = img.w;
+    cg.h = img.h;
+    cg.mag2.assign((size_t)cg.w * (size_t)cg.h, 0);
+    cg.ang.assign((size_t)cg.w * (size_t)cg.h, 0);
+    cg.mag.clear();
+    if (img.w <= 0 || img.h <= 0) return;
+
+    const NoyauxSobel& k = noyaux();
+    const TablesAngle& t = tablesAngle();
+    const uint32_t lim = seuilCarre(seuilAngle);
+    lignes.resize(2 * (size_t)img.w);
+    int16_t* gx = lignes.data();
+    int16_t* gy = gx + img.w;
+
+    for (int y = 0; y < img.h; ++y) {
+        ligneGradient(img, y, k, gx, gy);
+
+        uint32_t* m2 = &cg.mag2[(size_t)y * (size_t)cg.w];
+        uint16_t* a = &cg.a(y, 0);
+        for (int x = 0; x < img.w; ++x) {
+            m2[x] = (uint32_t)((int)gx[x] * gx[x] + (int)gy[x] * gy[x]);
+        }
+        for (int x = 0; x < img.w; ++x) {
+            if (m2[x] >= lim) a[x] = binRapide(gx[x], gy[x], t);
+        }
+    }
+}
+
+ChampGradient sobelRapide(const grayView& img, uint16_t seuilAngle) {
+    ChampGradient cg;
+    std::vector<int16_t> lignes;
+    sobelRapide(img, cg, lignes, seuilAngle);
+    return cg;
+}
+
+// gx/gy of one pixel, clamped to img at its border (same values as ligneGradient).
+static inline void gradientPixel(const grayView& img, int y, int x, int& gx, int& gy) {
+    if (y > 0 && y < img.h - 1 && x > 0 && x < img.w - 1) {
+        const uint8_t* r1 = img.p + (size_t)y * img.stride + (size_t)x;
+        const uint8_t* r0 = r1 - img.stride;
+        const uint8_t* r2 = r1 + img.stride;
+        gx = (r0[1] - r0[-1]) + 2 * (r1[1] - r1[-1]) + (r2[1] - r2[-1]);
+        gy = (r2[-1] + 2 * r2[0] + r2[1]) - (r0[-1] + 2 * r0[0] + r0[1]);
+        return;
+    }
+    auto at = [&](int yy, int xx) -> int {
+        xx = clampInt(xx, 0, img.w - 1);
+        yy = clampInt(yy, 0, img.h - 1);
+        return (int)img.at(yy, xx);
+    };
+    gx = -1 * at(y - 1, x - 1) + 1 * at(y - 1, x + 1) +
+         -2 * at(y,     x - 1) + 2 * at(y,     x + 1) +
+         -1 * at(y + 1, x - 1) + 1 * at(y + 1, x + 1);
+    gy = -1 * at(y - 1, x - 1) + -2 * at(y - 1, x) + -1 * at(y - 1, x + 1) +
+          1 * at(y + 1, x - 1) +  2 * at(y + 1, x) +  1 * at(y + 1, x + 1);
+}
+
+void completerAngles(ChampGradient& cg, const grayView& img, uint16_t seuilAngle) {
+    if (!cg.carre()) return;
+    const TablesAngle& t = tablesAngle();
+    const uint32_t lim = seuilCarre(seuilAngle);
+    for (int y = 0; y < cg.h; ++y) {
+        const uint32_t* m2 = &cg.mag2[(size_t)y * (size_t)cg.w];
+        uint16_t* a = &cg.a(y, 0);
+        for (int x = 0; x < cg.w; ++x) {
+            if (m2[x] < lim) continue;
+            int gx, gy;
+            gradientPixel(img, y, x, gx, gy);
+            a[x] = binRapide(gx, gy, t);
+        }
+    }
+}
+
+// -------------------- gradient views --------------------
+VueGradient vueGradient(const ChampGradient& cg) {
+    return sousVueGradient(cg, 0, 0, cg.w, cg.h);
+}
+
+VueGradient sousVueGradient(const ChampGradient& cg, int x0, int y0, int w, int h) {
+    const size_t o = (size_t)y0 * (size_t)cg.w + (size_t)x0;
+    VueGradient v;
+    v.w = w;
+    v.h = h;
+    v.stride = (size_t)cg.w;
+    v.mag = cg.carre() ? nullptr : cg.mag.data() + o;
+    v.mag2 = cg.carre() ? cg.mag2.data() + o : nullptr;
+    v.ang = cg.ang.data() + o;
+    return v;
+}
+
+void gradientRoiBordsClamp(const ChampGradient& cg, const grayView& img,
+                           int x0, int y0, int w, int h, uint16_t seuilAngle, ChampGradient& r) {
+    r.w = w;
+    r.h = h;
+    const size_t n = (size_t)w * (size_t)h;
+    const bool carre = cg.carre();
+    if (carre) { r.mag2.resize(n); r.mag.clear(); }
+    else       { r.mag.resize(n); r.mag2.clear(); }
+    r.ang.resize(n);
+    if (w <= 0 || h <= 0) return;
+
+    // interior: neighbours are inside the window, the frame field is already exact
+    for (int y = 0; y < h; ++y) {
+        const size_t src = (size_t)(y0 + y) * (size_t)cg.w + (size_t)x0;
+        const size_t dst = (size_t)y * (size_t)w;
+        if (carre) std::memcpy(&r.mag2[dst], &cg.mag2[src], (size_t)w * sizeof(uint32_t));
+        else       std::memcpy(&r.mag[dst], &cg.mag[src], (size_t)w * sizeof(uint16_t));
+        std::memcpy(&r.ang[dst], &cg.ang[src], (size_t)w * sizeof(uint16_t));
+    }
+
+    // ring: Sobel of the window itself, clamped at its edges
+    const grayView roi = sousVue(img, x0, y0, w, h);
+    const TablesAngle& t = tablesAngle();
+    const uint32_t lim = seuilCarre(seuilAngle);
+    auto anneau = [&](int y, int x) {
+        int gx, gy;
+        gradientPixel(roi, y, x, gx, gy);
+        const size_t i = (size_t)y * (size_t)w + (size_t)x;
+        if (carre) {
+            r.mag2[i] = (uint32_t)(gx * gx + gy * gy);
+            r.ang[i] = r.mag2[i] >= lim ? binRapide(gx, gy, t) : 0;
+        } else {
+            float m = std::sqrt((float)gx * (float)gx + (float)gy * (float)gy);
+            r.mag[i] = (uint16_t)clampInt((int)std::lround(m), 0, 65535);
+            r.ang[i] = (uint16_t)binDeg(std::atan2((float)gy, (float)gx));
+        }
+    };
+    for (int x = 0; x < w; ++x) {
+        anneau(0, x);
+        if (h > 1) anneau(h - 1, x);
+    }
+    for (int y = 1; y < h - 1; ++y) {
+        anneau(y, 0);
+        if (w > 1) anneau(y, w - 1);
+    }
+}
+
+ChampGradient gradientRoiBordsClamp(const ChampGradient& cg, const grayView& img,
+                                    int x0, int y0, int w, int h, uint16_t seuilAngle) {
+    ChampGradient r;
+    gradientRoiBordsClamp(cg, img, x0, y0, w, h, seuilAngle, r);
+    return r;
+}
+
+uint16_t ChampGradient::magnitude(int y, int x) const {
+    if (!carre()) return m(y, x);
+    float f = std::sqrt((float)mag2[(size_t)y * (size_t)w + (size_t)x]);
+    return (uint16_t)clampInt((int)std::lround(f), 0, 65535);
+}
@@ -0,0 +1,163 @@
+// FILE: vision/tests/test_allocations.cpp
+// Steady-state allocations of the workspace path (sobel -> calculerSeuils ->
+// detectfaceeyesGradient on an EspaceTravail, and analyser() with preprocessing off): after
+// a warm-up over every frame, a further pass must not reach operator new, without a pool,
+// with one, with forced vote tiles, on the face volume and on the pyramid.
+#include "ght_core.hpp"
+#include "ght_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static std::atomic<bool> gCompter{false};
+static std::atomic<long> gAllocations{0};
+
+static void* allouer(std::size_t n) {
+    if (gCompter.load(std::memory_order_relaxed)) gAllocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t n) { return allouer(n); }
+void* operator new[](std::size_t n) { return allouer(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+    try { return allouer(n); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+    try { return allouer(n); } catch (...) { return nullptr; }
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// xorshift32: the same frames on every platform
+struct Alea {
+    uint32_t s;
+    explicit Alea(uint32_t graine) : s(graine ? graine : 1) {}
+    uint32_t operator()() { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+    int entre(int a, int b) { return a + (int)((*this)() % (uint32_t)(b - a + 1)); }
+};
+
+// A bright face ellipse with two dark eyes on a ramp, plus noise, blurred.
+static grayImage trameSynthetique(uint32_t graine) {
+    Alea r(graine);
+    grayImage g;
+    g.w = r.entre(320, 640);
+    g.h = r.entre(240, 480);
+    g.p.assign((size_t)g.w * (size_t)g.h, 0);
+    const double rx = r.entre(30, 70), ry = rx * 1.9;
+    const double cx = r.entre((int)rx + 5, std::max((int)rx + 5, g.w - (int)rx - 5));
+    const double cy = r.entre((int)ry + 5, std::max((int)ry + 5, g.h - (int)ry - 5));
+    const double er = std::max(3.0, rx * 0.18), ey = cy - ry * 0.35;
+    for (int y = 0; y < g.h; ++y) {
+        for (int x = 0; x < g.w; ++x) {
+            const double d = (x - cx) * (x - cx) / (rx * rx) + (y - cy) * (y - cy) / (ry * ry);
+            int v = d < 1.0 ? 190 : 60 + x / 10;
+            if (std::hypot(x - (cx - rx * 0.42), y - ey) < er || std::hypot(x - (cx + rx * 0.42), y - ey) < er) v = 30;
+            v += r.entre(-12, 12);
+            g.at(y, x) = (uint8_t)std::min(255, std::max(0, v));
+        }
+    }
+    // 5x5 binomial blur (pretraiter()'s default), clamped borders
+    static const int k[5] = {1, 4, 6, 4, 1};
+    for (int passe = 0; passe < 2; ++passe) {
+        const grayImage t = g;
+        for (int y = 0; y < g.h; ++y) {
+            for (int x = 0; x < g.w; ++x) {
+                int somme = 0;
+                for (int i = -2; i <= 2; ++i) {
+                    const int xx = passe ? x : std::min(g.w - 1, std::max(0, x + i));
+                    const int yy = passe ? std::min(g.h - 1, std::max(0, y + i)) : y;
+                    somme += k[i + 2] * t.at(yy, xx);
+                }
+                g.at(y, x) = (uint8_t)((somme + 8) / 16);
+            }
+        }
+    }
+    return g;
+}
+
+// sobel -> calculerSeuils -> detectfaceeyesGradient, or the whole analyser() on a gray
+// frame; returns the faces found.
+static int detecter(const std::vector<grayImage>& trames, const BanqueModeles& banque,
+                    const OptionsDetection& opt, EspaceTravail& ws, bool pipeline) {
+    int visages = 0;
+    for (const grayImage& t : trames) {
+        faceeyes r;
+        if (pipeline) {
+            const cv::Mat m(t.h, t.w, CV_8UC1, const_cast<uint8_t*>(t.p.data()), (size_t)t.w);
+            Seuils s;
+            r = analyser(m, banque, opt, s, nullptr, false, nullptr, &ws);
+        } else {
+            const grayView v = vue(t);
+            sobel(v, ws.grads, ws.lignesSobel);
+            const Seuils s = calculerSeuils(ws.grads, opt, &ws.echantillons);
+            r = detectfaceeyesGradient(v, ws, banque.faces, banque.yeux, s.edgeFace, s.edgeEye,
+                                       s.faceMinScore, s.eyeMinPeak, opt.moteur);
+        }
+        visages += r.faceOk;
+    }
+    return visages;
+}
+
+// Allocations of a third pass; a configuration that finds no face proves nothing and fails.
+static bool verifier(const char* nom, const std::vector<grayImage>& trames, const BanqueModeles& banque,
+                     const OptionsDetection& opt, bool pipeline = false) {
+    EspaceTravail ws;
+    for (int passe = 0; passe < 2; ++passe) detecter(trames, banque, opt, ws, pipeline);
+    gAllocations.store(0);
+    gCompter.store(true);
+    const int visages = detecter(trames, banque, opt, ws, pipeline);
+    gCompter.store(false);
+    const long n = gAllocations.load();
+    std::printf("%-16s %ld allocations, %d/%zu visages\n", nom, n, visages, trames.size());
+    return n == 0 && visages > 0;
+}
+
+int main() {
+    const BanqueModeles banque = construireBanqueModeles();
+    std::vector<grayImage> trames;
+    for (uint32_t i = 1; i <= 6; ++i) trames.push_back(trameSynthetique(0x9e3779b9u * i));
+
+    // the bank's ellipse and circle tables, which vote on these frames
+    bool ok = true;
+    OptionsDetection opt;
+    opt.moteur.visageEllipse = opt.moteur.yeuxCercle = true;
+    ok &= verifier("sans pool", trames, banque, opt);
+
+    PoolTaches pool(3);
+    opt.moteur.pool = &pool;
+    ok &= verifier("pool", trames, banque, opt);
+    opt.moteur.tuilesVote = 4;
+    ok &= verifier("pool+tuiles", trames, banque, opt);
+
+    opt.moteur.volumeFace = true;
+    ok &= verifier("volume+tuiles", trames, banque, opt);
+    opt.moteur.pool = nullptr;
+    ok &= verifier("volume", trames, banque, opt);
+
+    opt.moteur.volumeFace = false;
+    opt.moteur.pyramide = 2;
+    ok &= verifier("pyramide 2", trames, banque, opt);
+    opt.moteur.pool = &pool;
+    opt.moteur.pyramide = 4;
+    ok &= verifier("pyramide 4", trames, banque, opt);
+
+    // analyser() itself, preprocessing off (OpenCV's own buffers are not counted on)
+    opt.moteur.pyramide = 1;
+    opt.useEqHist = false;
+    opt.blurK = 0;
+    ok &= verifier("analyser", trames, banque, opt, true);
+    opt.moteur.pool = nullptr;
+    opt.moteur.gradientRapide = true;
+    ok &= verifier("analyser rapide", trames, banque, opt, true);
+    return ok ? 0 : 1;
+}
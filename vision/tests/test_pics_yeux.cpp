@@ -0,0 +1,186 @@
+// FILE: vision/tests/test_pics_yeux.cpp
+// topKpicsAvecBary() against a brute-force reference: every candidate sorted by the
+// documented total order (value descending, then y, then x), greedy NMS, barycentres from
+// direct window sums. Synthetic eye accumulators (blobs on integer noise, so many equal
+// vote counts), through the scan, the crossing-list and the summed-area paths. A small
+// golden file pins the picks on tie-free accumulators; `--ecrire` rewrites it.
+#include "ght_core.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// xorshift32: the same corpus on every platform (no std:: distributions)
+struct Alea {
+    uint32_t s;
+    explicit Alea(uint32_t graine) : s(graine ? graine : 1) {}
+    uint32_t operator()() { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+    int entre(int a, int b) { return a + (int)((*this)() % (uint32_t)(b - a + 1)); }
+};
+
+static AccuImage accuSynthetique(uint32_t graine) {
+    Alea r(graine);
+    AccuImage A = makeAccu(r.entre(60, 320), r.entre(40, 200));
+    const int bruit = r.entre(2, 12);
+    for (uint16_t& v : A.a) v = (uint16_t)r.entre(0, bruit);
+    const int nBlobs = r.entre(1, 8);
+    for (int b = 0; b < nBlobs; ++b) {
+        const int cx = r.entre(0, A.w - 1), cy = r.entre(0, A.h - 1);
+        const int rayon = r.entre(2, 9), haut = r.entre(bruit, bruit + 30);
+        for (int y = std::max(0, cy - rayon); y <= std::min(A.h - 1, cy + rayon); ++y) {
+            for (int x = std::max(0, cx - rayon); x <= std::min(A.w - 1, cx + rayon); ++x) {
+                const int d = std::max(std::abs(x - cx), std::abs(y - cy));
+                // flat tops and terraces: ties inside and between blobs
+                A.at(y, x) = (uint16_t)std::min(65535, A.at(y, x) + std::max(0, haut - 3 * (d / 2)));
+            }
+        }
+    }
+    return A;
+}
+
+// Every value distinct (a shuffled ramp): the picks do not depend on any tie rule.
+static AccuImage accuSansEgalites(uint32_t graine) {
+    Alea r(graine);
+    AccuImage A = makeAccu(r.entre(20, 120), r.entre(20, 120));
+    for (size_t i = 0; i < A.a.size(); ++i) A.a[i] = (uint16_t)(i + 1);
+    for (size_t i = A.a.size(); i > 1; --i) std::swap(A.a[i - 1], A.a[r() % i]);
+    return A;
+}
+
+static std::vector<PicPoint> reference(const AccuImage& A, int k, int nms, int bary, uint16_t minVal) {
+    std::vector<Candidat> cands;
+    for (int y = 0; y < A.h; ++y) {
+        for (int x = 0; x < A.w; ++x) {
+            if (A.at(y, x) >= minVal) cands.push_back({x, y, A.at(y, x)});
+        }
+    }
+    std::sort(cands.begin(), cands.end(), [](const Candidat& a, const Candidat& b) {
+        if (a.v != b.v) return a.v > b.v;
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+    std::vector<PicPoint> out;
+    for (const Candidat& c : cands) {
+        if ((int)out.size() >= k) break;
+        bool proche = false;
+        for (const PicPoint& p : out) {
+            if ((c.x - p.x) * (c.x - p.x) + (c.y - p.y) * (c.y - p.y) <= nms * nms) { proche = true; break; }
+        }
+        if (proche) continue;
+        uint64_t sum = 0, sx = 0, sy = 0;
+        for (int y = std::max(0, c.y - bary); y <= std::min(A.h - 1, c.y + bary); ++y) {
+            for (int x = std::max(0, c.x - bary); x <= std::min(A.w - 1, c.x + bary); ++x) {
+                sum += A.at(y, x);
+                sx += (uint64_t)A.at(y, x) * (uint64_t)x;
+                sy += (uint64_t)A.at(y, x) * (uint64_t)y;
+            }
+        }
+        PicPoint p;
+        p.x = c.x; p.y = c.y; p.v = c.v;
+        if (sum > 0) { p.bx = (float)((double)sx / (double)sum); p.by = (float)((double)sy / (double)sum); }
+        else { p.bx = (float)c.x; p.by = (float)c.y; }
+        out.push_back(p);
+    }
+    return out;
+}
+
+static std::string texte(const std::vector<PicPoint>& pics) {
+    std::string s = std::to_string(pics.size());
+    char buf[96];
+    for (const PicPoint& p : pics) {
+        std::snprintf(buf, sizeof(buf), " (%d,%d,%u,%.3f,%.3f)", p.x, p.y, (unsigned)p.v, p.bx, p.by);
+        s += buf;
+    }
+    return s;
+}
+
+static bool memes(const std::vector<PicPoint>& a, const std::vector<PicPoint>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].v != b[i].v || a[i].bx != b[i].bx || a[i].by != b[i].by) return false;
+    }
+    return true;
+}
+
+// Each path against the reference; returns the number of mismatches.
+static int proprietes() {
+    int ecarts = 0;
+    auto verifier = [&](int cas, const char* voie, const std::vector<PicPoint>& obtenu, const std::vector<PicPoint>& attendu) {
+        if (memes(obtenu, attendu)) return;
+        if (ecarts++ < 5) std::cerr << "cas " << cas << ' ' << voie << "\nattendu: " << texte(attendu) << "\nobtenu:  " << texte(obtenu) << "\n";
+    };
+    std::vector<PicPoint> out;
+    std::vector<Candidat> cands;
+    for (int cas = 0; cas < 400; ++cas) {
+        const AccuImage A = accuSynthetique(0x9e3779b9u * (uint32_t)(cas + 1));
+        Alea r((uint32_t)cas * 7919u + 13u);
+        // large k with small radii consumes several selection blocks
+        const int k = cas % 4 == 3 ? r.entre(100, 600) : r.entre(1, 8);
+        const int nms = cas % 4 == 3 ? r.entre(0, 3) : r.entre(4, 36);
+        const int bary = r.entre(2, 6);
+        const uint16_t minVal = (uint16_t)r.entre(1, 10);
+        const std::vector<PicPoint> attendu = reference(A, k, nms, bary, minVal);
+
+        verifier(cas, "scan", topKpicsAvecBary(A, k, nms, bary, minVal), attendu);
+        IntegralesAccu I;
+        integralesAccu(A, I);
+        verifier(cas, "integrales", topKpicsAvecBary(A, k, nms, bary, minVal, nullptr, &I), attendu);
+
+        // crossing list as voting leaves it: the cells >= seuil, in no particular order
+        SuiviPic suivi;
+        suivi.seuil = minVal;
+        for (uint32_t i = 0; i < (uint32_t)A.a.size(); ++i) {
+            if (A.a[i] >= suivi.seuil) suivi.auDessus.push_back(i);
+        }
+        for (size_t i = suivi.auDessus.size(); i > 1; --i) std::swap(suivi.auDessus[i - 1], suivi.auDessus[r() % i]);
+        topKpicsAvecBary(A, suivi, k, nms, bary, out, cands);
+        verifier(cas, "suivi", out, attendu);
+    }
+    return ecarts;
+}
+
+static std::string corpusSansEgalites() {
+    std::ostringstream os;
+    for (int cas = 0; cas < 24; ++cas) {
+        const AccuImage A = accuSansEgalites(0x85ebca6bu * (uint32_t)(cas + 1));
+        Alea r((uint32_t)cas * 104729u + 7u);
+        const int k = r.entre(1, 8), nms = r.entre(2, 20), bary = r.entre(1, 5);
+        os << cas << ' ' << texte(topKpicsAvecBary(A, k, nms, bary, (uint16_t)r.entre(1, 100))) << '\n';
+    }
+    return os.str();
+}
+
+int main(int argc, char** argv) {
+    const bool ecrire = argc > 1 && std::strcmp(argv[1], "--ecrire") == 0;
+    const std::string chemin = argc > (ecrire ? 2 : 1) ? argv[ecrire ? 2 : 1] : "golden/pics_yeux.txt";
+    const std::string obtenu = corpusSansEgalites();
+    if (ecrire) {
+        std::ofstream(chemin) << obtenu;
+        return 0;
+    }
+
+    const int ecartsReference = proprietes();
+    std::cout << "reference: " << ecartsReference << " ecarts\n";
+
+    std::ifstream f(chemin);
+    if (!f) {
+        std::cerr << "golden introuvable: " << chemin << "\n";
+        return 2;
+    }
+    std::istringstream attendu((std::ostringstream() << f.rdbuf()).str()), lu(obtenu);
+    std::string a, b;
+    int n = 0, ecarts = 0;
+    while (std::getline(attendu, a)) {
+        if (!std::getline(lu, b)) b.clear();
+        ++n;
+        if (a != b && ecarts++ < 5) std::cerr << "attendu: " << a << "\nobtenu:  " << b << "\n";
+    }
+    if (std::getline(lu, b)) ++ecarts;
+    std::cout << "golden: " << n << " lignes, " << ecarts << " ecarts\n";
+    return ecarts == 0 && ecartsReference == 0 ? 0 : 1;
+}
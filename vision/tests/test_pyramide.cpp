@@ -0,0 +1,123 @@
+// FILE: vision/tests/test_pyramide.cpp
+// OptionsMoteur::pyramide against the full search: on a synthetic corpus (face ellipse
+// with two eyes, ramp background, noise, the 5x5 blur of pretraiter()), the face found
+// with the pyramid at 1/2 and 1/4 must have the full search's scale and lie within a
+// pixel of its position, on the bank's ellipse tables and on template tables (ring
+// templates drawn here, every edge magnitude kept).
+#include "ght_core.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// xorshift32: the same frames on every platform
+struct Alea {
+    uint32_t s;
+    explicit Alea(uint32_t graine) : s(graine ? graine : 1) {}
+    uint32_t operator()() { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+    int entre(int a, int b) { return a + (int)((*this)() % (uint32_t)(b - a + 1)); }
+};
+
+static grayImage trameSynthetique(uint32_t graine, int bruit) {
+    Alea r(graine);
+    grayImage g;
+    g.w = r.entre(320, 720);
+    g.h = r.entre(240, 540);
+    g.p.assign((size_t)g.w * (size_t)g.h, 0);
+    const double rx = r.entre(28, 77), ry = rx * (1.86 + r.entre(0, 7) / 100.0);
+    const double cx = r.entre((int)rx + 10, std::max((int)rx + 10, g.w - (int)rx - 10));
+    const double cy = r.entre((int)ry + 10, std::max((int)ry + 10, g.h - (int)ry - 10));
+    const double er = std::max(3.0, rx * 0.18), ey = cy - ry * 0.35;
+    for (int y = 0; y < g.h; ++y) {
+        for (int x = 0; x < g.w; ++x) {
+            const double d = (x - cx) * (x - cx) / (rx * rx) + (y - cy) * (y - cy) / (ry * ry);
+            int v = d < 1.0 ? 190 : 60 + x / 10;
+            if (std::hypot(x - (cx - rx * 0.42), y - ey) < er || std::hypot(x - (cx + rx * 0.42), y - ey) < er) v = 30;
+            // sum of three uniforms: roughly gaussian, sigma about bruit
+            v += (r.entre(-bruit, bruit) + r.entre(-bruit, bruit) + r.entre(-bruit, bruit)) * 10 / 17;
+            g.at(y, x) = (uint8_t)std::min(255, std::max(0, v));
+        }
+    }
+    // 5x5 binomial blur, clamped borders
+    static const int k[5] = {1, 4, 6, 4, 1};
+    for (int passe = 0; passe < 2; ++passe) {
+        const grayImage t = g;
+        for (int y = 0; y < g.h; ++y) {
+            for (int x = 0; x < g.w; ++x) {
+                int s = 0;
+                for (int i = -2; i <= 2; ++i) {
+                    const int xx = passe ? x : std::min(g.w - 1, std::max(0, x + i));
+                    const int yy = passe ? std::min(g.h - 1, std::max(0, y + i)) : y;
+                    s += k[i + 2] * t.at(yy, xx);
+                }
+                g.at(y, x) = (uint8_t)((s + 8) / 16);
+            }
+        }
+    }
+    return g;
+}
+
+// Face tables from ring templates, as construireBanqueModeles() draws them.
+static void tablesGabarits(BanqueModeles& banque) {
+    for (facemodel& fm : banque.faces) {
+        grayImage t;
+        t.w = 2 * fm.rx + 60;
+        t.h = 2 * fm.ry + 60;
+        t.p.assign((size_t)t.w * (size_t)t.h, 255);
+        for (int y = 0; y < t.h; ++y) {
+            for (int x = 0; x < t.w; ++x) {
+                const float dx = (float)(x - t.w / 2), dy = (float)(y - t.h / 2);
+                const float v = dx * dx / (float)(fm.rx * fm.rx) + dy * dy / (float)(fm.ry * fm.ry);
+                if (std::fabs(v - 1.0f) < 0.03f) t.at(y, x) = 0;
+            }
+        }
+        fm.lut = construireRTableDepuisTemplate(t, 50, 65535);
+        fm.reduites = {reduireRTable(fm.lut, 2), reduireRTable(fm.lut, 4)};
+    }
+}
+
+static faceeyes detecter(const grayImage& trame, const BanqueModeles& banque, const OptionsDetection& opt,
+                         EspaceTravail& ws) {
+    const grayView v = vue(trame);
+    sobel(v, ws.grads, ws.lignesSobel);
+    const Seuils s = calculerSeuils(ws.grads, opt, &ws.echantillons);
+    return detectfaceeyesGradient(v, ws, banque.faces, banque.yeux, s.edgeFace, s.edgeEye,
+                                  s.faceMinScore, s.eyeMinPeak, opt.moteur);
+}
+
+int main(int argc, char** argv) {
+    const int nTrames = argc > 1 ? std::atoi(argv[1]) : 48;
+    const BanqueModeles banque = construireBanqueModeles();
+    BanqueModeles gabarits = banque;
+    tablesGabarits(gabarits);
+    EspaceTravail wsComplet, wsPyramide;
+    int ecarts = 0, cas = 0, visages = 0;
+    for (int ellipse = 0; ellipse < 2; ++ellipse) {
+        const BanqueModeles& b = ellipse ? banque : gabarits;
+        for (int n = 0; n < nTrames; ++n) {
+            const grayImage trame = trameSynthetique(0x9e3779b9u * (uint32_t)(n + 1), n % 2 ? 20 : 8);
+            OptionsDetection opt;
+            opt.moteur.visageEllipse = ellipse != 0;
+            const faceeyes complet = detecter(trame, b, opt, wsComplet);
+            visages += complet.faceOk;
+            for (int facteur : {2, 4}) {
+                opt.moteur.pyramide = facteur;
+                const faceeyes p = detecter(trame, b, opt, wsPyramide);
+                ++cas;
+                const bool ok = p.faceOk == complet.faceOk &&
+                                (!p.faceOk || (p.faceRx == complet.faceRx && p.faceRy == complet.faceRy &&
+                                               std::abs(p.faceX - complet.faceX) <= 1 && std::abs(p.faceY - complet.faceY) <= 1));
+                if (!ok && ecarts++ < 10) {
+                    std::fprintf(stderr, "trame %d ellipse %d pyramide %d: (%d, %d) %dx%d, complet (%d, %d) %dx%d\n",
+                                 n, ellipse, facteur, p.faceX, p.faceY, p.faceRx, p.faceRy,
+                                 complet.faceX, complet.faceY, complet.faceRx, complet.faceRy);
+                }
+            }
+        }
+    }
+    std::printf("pyramide: %d cas (%d visages), %d ecarts\n", cas, visages, ecarts);
+    return ecarts == 0 && visages > 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+// FILE: vision/tests/test_sobel_rapide.cpp
+// sobelRapide() against sobel(). The LUT bins (with the guard-band atan2 fallback) must
+// equal the atan2 bins for every (gx, gy) in the reachable range, |gx|, |gy| <= 1020.
+// seuilCarre(T) must select exactly the pixels whose rounded magnitude reaches T. On
+// random images the two fields must give the same edge lists (extraireBords) and the
+// same bins on them, directly and through completerAngles().
+#include "ght_core.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+static const int kGradMax = 1020;  // 4 * 255
+
+// xorshift32: the same images on every platform
+struct Alea {
+    uint32_t s;
+    explicit Alea(uint32_t graine) : s(graine ? graine : 1) {}
+    uint32_t operator()() { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+    int entre(int a, int b) { return a + (int)((*this)() % (uint32_t)(b - a + 1)); }
+};
+
+// Every (gx, gy): same bin, and the rounded magnitude m satisfies
+// seuilCarre(m) <= gx^2 + gy^2 < seuilCarre(m + 1), i.e. "m >= T <=> s >= seuilCarre(T)".
+static long balayage() {
+    long ecarts = 0;
+    for (int gy = -kGradMax; gy <= kGradMax; ++gy) {
+        for (int gx = -kGradMax; gx <= kGradMax; ++gx) {
+            const uint16_t attendu = binSobel(gx, gy), obtenu = binSobelRapide(gx, gy);
+            const uint32_t s = (uint32_t)(gx * gx + gy * gy);
+            const int m = (int)std::lround(std::sqrt((float)gx * (float)gx + (float)gy * (float)gy));
+            const bool seuilOk = s >= seuilCarre((uint16_t)m) && s < seuilCarre((uint16_t)(m + 1));
+            if (attendu != obtenu || !seuilOk) {
+                if (ecarts++ < 5) std::fprintf(stderr, "(%d,%d): bin %u/%u m %d s %u\n", gx, gy, attendu, obtenu, m, s);
+            }
+        }
+    }
+    return ecarts;
+}
+
+static bool memesBords(const ListeBords& a, const ListeBords& b) {
+    return a.w == b.w && a.h == b.h && a.nBandes == b.nBandes && a.x == b.x && a.y == b.y && a.debut == b.debut;
+}
+
+// mode 0: noise, 1: 0/255, 2: blurred blobs (long, smooth edges at every angle)
+static grayImage image(Alea& r, int mode) {
+    grayImage g;
+    g.w = r.entre(8, 400);
+    g.h = r.entre(8, 300);
+    g.p.assign((size_t)g.w * (size_t)g.h, 0);
+    const int cx = r.entre(0, g.w), cy = r.entre(0, g.h), rayon = r.entre(4, 120);
+    for (int y = 0; y < g.h; ++y) {
+        for (int x = 0; x < g.w; ++x) {
+            int v;
+            if (mode == 0) v = r.entre(0, 255);
+            else if (mode == 1) v = (r() & 1) * 255;
+            else v = (int)(128 + 100 * std::tanh((rayon - std::hypot(x - cx, y - cy)) / 3.0)) + r.entre(-2, 2);
+            g.at(y, x) = (uint8_t)std::min(255, std::max(0, v));
+        }
+    }
+    return g;
+}
+
+static int images() {
+    Alea r(0x6a09e667u);
+    int ecarts = 0;
+    const uint16_t seuils[] = {0, 1, 20, 75, 140, 400, 1000};
+    for (int n = 0; n < 90; ++n) {
+        const grayImage g = image(r, n % 3);
+        const grayView v = vue(g);
+        const ChampGradient exact = sobel(v);
+        for (uint16_t T : seuils) {
+            const ChampGradient rapide = sobelRapide(v, T);
+            ChampGradient complete = sobelRapide(v, 65535);
+            completerAngles(complete, v, T);
+            const ListeBords a = extraireBords(vueGradient(exact), T);
+            const ListeBords b = extraireBords(vueGradient(rapide), T);
+            const ListeBords c = extraireBords(vueGradient(complete), T);
+            bool ok = memesBords(a, b) && memesBords(a, c);
+            for (size_t i = 0; ok && i < exact.mag.size(); ++i) {
+                if ((exact.mag[i] >= T) != (rapide.mag2[i] >= seuilCarre(T))) ok = false;
+                else if (exact.mag[i] >= T && (rapide.ang[i] != exact.ang[i] || complete.ang[i] != exact.ang[i])) ok = false;
+            }
+            if (!ok && ecarts++ < 5) std::fprintf(stderr, "image %d (%dx%d) seuil %u differe\n", n, g.w, g.h, (unsigned)T);
+        }
+    }
+    return ecarts;
+}
+
+int main() {
+    const long ecartsBalayage = balayage();
+    const int ecartsImages = images();
+    std::printf("balayage (gx, gy): %ld ecarts, images: %d ecarts\n", ecartsBalayage, ecartsImages);
+    return ecartsBalayage == 0 && ecartsImages == 0 ? 0 : 1;
+}
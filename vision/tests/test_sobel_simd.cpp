@@ -0,0 +1,104 @@
+// FILE: vision/tests/test_sobel_simd.cpp
+// sobel() on the instruction set forced by GHT_SIMD (ctest runs this once per level)
+// against a plain per-pixel reference with clamped reads: gx, gy, magnitude and angle bin
+// must be identical. Random and saturated images, every width up to 40 (odd widths and
+// widths under one vector included), padded strides. Exit 77 (skipped) when the CPU lacks
+// the requested level.
+#include "ght_core.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// xorshift32: the same images on every platform
+struct Alea {
+    uint32_t s;
+    explicit Alea(uint32_t graine) : s(graine ? graine : 1) {}
+    uint32_t operator()() { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+    int entre(int a, int b) { return a + (int)((*this)() % (uint32_t)(b - a + 1)); }
+};
+
+struct Image {
+    int w = 0, h = 0;
+    size_t stride = 0;
+    std::vector<uint8_t> p;
+    grayView vue() const { grayView v; v.w = w; v.h = h; v.stride = stride; v.p = p.data(); return v; }
+};
+
+// mode 0: uniform noise, 1: 0/255 only (|gx|, |gy| up to 1020), 2: smooth ramp + noise
+static Image image(Alea& r, int w, int h, int mode) {
+    Image im;
+    im.w = w;
+    im.h = h;
+    im.stride = (size_t)w + (size_t)r.entre(0, 9);
+    im.p.assign(im.stride * (size_t)h, 0xA5);  // padding bytes must never be read
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            int v = mode == 0 ? r.entre(0, 255) : mode == 1 ? (r() & 1) * 255 : (3 * x + 5 * y) % 256 + r.entre(-3, 3);
+            im.p[(size_t)y * im.stride + (size_t)x] = (uint8_t)std::min(255, std::max(0, v));
+        }
+    }
+    return im;
+}
+
+static int binReference(int gx, int gy) {
+    float deg = std::atan2((float)gy, (float)gx) * 180.0f / float(M_PI);
+    int b = (int)std::lround(deg) % 360;
+    return b < 0 ? b + 360 : b;
+}
+
+static int verifier(const Image& im) {
+    const grayView v = im.vue();
+    auto at = [&](int y, int x) -> int {
+        return (int)v.at(std::min(v.h - 1, std::max(0, y)), std::min(v.w - 1, std::max(0, x)));
+    };
+    std::vector<int16_t> gx, gy;
+    composantesSobel(v, gx, gy);
+    const ChampGradient cg = sobel(v);
+    int ecarts = 0;
+    for (int y = 0; y < v.h; ++y) {
+        for (int x = 0; x < v.w; ++x) {
+            const int rx = (at(y - 1, x + 1) - at(y - 1, x - 1)) + 2 * (at(y, x + 1) - at(y, x - 1)) + (at(y + 1, x + 1) - at(y + 1, x - 1));
+            const int ry = (at(y + 1, x - 1) + 2 * at(y + 1, x) + at(y + 1, x + 1)) - (at(y - 1, x - 1) + 2 * at(y - 1, x) + at(y - 1, x + 1));
+            const int rm = (int)std::lround(std::sqrt((float)rx * (float)rx + (float)ry * (float)ry));
+            const size_t i = (size_t)y * (size_t)v.w + (size_t)x;
+            if (gx[i] != rx || gy[i] != ry || cg.mag[i] != rm || cg.ang[i] != binReference(rx, ry)) {
+                if (ecarts++ < 3) {
+                    std::fprintf(stderr, "%dx%d (%d,%d): gx %d/%d gy %d/%d mag %u/%d bin %u/%d\n", v.w, v.h, x, y,
+                                 gx[i], rx, gy[i], ry, (unsigned)cg.mag[i], rm, (unsigned)cg.ang[i], binReference(rx, ry));
+                }
+            }
+        }
+    }
+    return ecarts;
+}
+
+int main(int argc, char** argv) {
+    const char* voulu = argc > 1 ? argv[1] : "scalar";
+    if (std::strcmp(sobelIsa(), voulu) != 0) {
+        std::printf("sobel: %s demande, %s disponible: ignore\n", voulu, sobelIsa());
+        return std::strcmp(voulu, "scalar") == 0 ? 1 : 77;
+    }
+
+    Alea r(0x2545f491u);
+    int ecarts = 0, images = 0;
+    for (int w = 1; w <= 40; ++w) {
+        for (int h = 1; h <= 4; ++h) {
+            for (int mode = 0; mode < 3; ++mode) { ecarts += verifier(image(r, w, h, mode)); ++images; }
+        }
+    }
+    for (int n = 0; n < 60; ++n) {
+        ecarts += verifier(image(r, r.entre(41, 700) | 1, r.entre(2, 64), n % 3));
+        ecarts += verifier(image(r, r.entre(41, 700), r.entre(2, 64), n % 3));
+        images += 2;
+    }
+    std::printf("sobel %s: %d images, %d ecarts\n", sobelIsa(), images, ecarts);
+    return ecarts == 0 ? 0 : 1;
+}